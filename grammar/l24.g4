@@ -11,6 +11,7 @@ Continue : 'continue';
 Break : 'break';
 Return : 'return';
 Const : 'const';
+Extern : 'extern';
 Int : 'int' | 'char';
 Void : 'void';
 
@@ -49,10 +50,10 @@ Ident :                [a-zA-Z_][a-zA-Z0-9_]*;
  
 //空白字符，抛弃
 Whitespace
-    : [ \t]+ -> channel(HIDDEN)
+    : [ \t]+ -> skip
     ;
 Newline
-    : ('\r' '\n'? | '\n') -> channel(HIDDEN)
+    : ('\r' '\n'? | '\n') -> skip
     ;
 
 // comments, skip
@@ -61,15 +62,23 @@ LINECOMMENT:             '//' ~[\r\n]* -> skip;
 
 
 // parser
+// FrontEnd parses the items one at a time with item(), so that the parse tree and the
+// tokens of an item can be released as soon as its AST is built
 entry
-    : program
+    : item+ EOF
     ;
 
-program
+item
     : decl
     | func
-    | program decl
-    | program func
+    | externDecl
+    ;
+
+// declarations of functions/globals defined in another translation unit
+externDecl
+    : 'extern' Int Ident '(' (funcFParams)? ')' ';'
+    | 'extern' 'void' Ident '(' (funcFParams)? ')' ';'
+    | 'extern' bType Ident ('[' (exp)? ']')? ';'
     ;
 
 func
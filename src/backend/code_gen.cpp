@@ -1,16 +1,87 @@
+#include <algorithm>
+#include <mutex>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Passes/StandardInstrumentations.h"
+
 #include "backend/code_gen.h"
 #include "frontend/type.h"
+#include "support/phase_timer.h"
 
 namespace l24 {
-void CodeGenBase::asmGen() const {
+llvm::CodeGenOptLevel CodeGenBase::getCodeGenOptLevel(unsigned opt_level) {
+    switch (opt_level) {
+    case 0: return llvm::CodeGenOptLevel::None;
+    case 1: return llvm::CodeGenOptLevel::Less;
+    case 2: return llvm::CodeGenOptLevel::Default;
+    default: return llvm::CodeGenOptLevel::Aggressive;
+    }
+}
+
+void CodeGenBase::optimize(llvm::Module &module, llvm::TargetMachine *target_machine,
+                           unsigned opt_level) {
+    // -O0 still runs the (almost empty) O0 pipeline, which keeps always-inline etc. correct
+    llvm::OptimizationLevel level;
+    switch (opt_level) {
+    case 0: level = llvm::OptimizationLevel::O0; break;
+    case 1: level = llvm::OptimizationLevel::O1; break;
+    case 2: level = llvm::OptimizationLevel::O2; break;
+    default: level = llvm::OptimizationLevel::O3; break;
+    }
+
+    PhaseTimer timer("optimize", "Optimization");
+
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    // per pass -ftime-trace events and -ftime-report timings
+    llvm::PassInstrumentationCallbacks PIC;
+    llvm::StandardInstrumentations SI(module.getContext(), false);
+    SI.registerCallbacks(PIC, &MAM);
+
+    // the default pipelines already contain SROA(mem2reg), InstCombine, GVN and LICM,
+    // the vectorizers are only enabled from -O2 like clang does
+    llvm::PipelineTuningOptions PTO;
+    PTO.LoopVectorization = opt_level >= 2;
+    PTO.SLPVectorization = opt_level >= 2;
+    PTO.LoopUnrolling = opt_level >= 2;
+
+    llvm::PassBuilder PB(target_machine, PTO, std::nullopt, &PIC);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager MPM;
+    if (level == llvm::OptimizationLevel::O0) {
+        MPM = PB.buildO0DefaultPipeline(level);
+    } else {
+        MPM = PB.buildPerModuleDefaultPipeline(level);
+    }
+    MPM.run(module, MAM);
+}
+
+void CodeGenBase::initTargets() {
+    // the target registry is global, only initialize it once even with many workers
+    static std::once_flag flag;
+    std::call_once(flag, [] {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmParsers();
+        llvm::InitializeAllAsmPrinters();
+    });
+}
+
+std::unique_ptr<llvm::TargetMachine> CodeGenBase::createTargetMachine(const CodeGenOptions &opts) {
     // Initialize the target registry etc.
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
+    initTargets();
     auto TargetTriple = llvm::sys::getDefaultTargetTriple();
-    (_ctx._module)->setTargetTriple(TargetTriple);
 
     std::string Error;
     auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
@@ -19,79 +90,113 @@ void CodeGenBase::asmGen() const {
     // This generally occurs if we've forgotten to initialise the
     // TargetRegistry or we have a bogus target triple.
     if (!Target) {
-        llvm::errs() << Error;
-        return ;
+        CodeGenContext::LogError(Error);
     }
 
-    auto CPU = "generic";
-    auto Features = "";
-
     llvm::TargetOptions opt;
-    auto TheTargetMachine = Target->createTargetMachine(
-        TargetTriple, CPU, Features, opt, llvm::Reloc::PIC_);
+    return std::unique_ptr<llvm::TargetMachine>(Target->createTargetMachine(
+        TargetTriple, opts._cpu, opts._features, opt, llvm::Reloc::PIC_, std::nullopt,
+        getCodeGenOptLevel(opts._opt_level)));
+}
+
+std::string CodeGenBase::getHostFeatures() {
+    std::vector<std::string> features;
+    llvm::StringMap<bool> host_features;
+    if (llvm::sys::getHostCPUFeatures(host_features)) {
+        for (const auto &feature : host_features) {
+            features.push_back((feature.getValue() ? "+" : "-") + feature.getKey().str());
+        }
+        // StringMap has no stable order, keep the attribute deterministic
+        std::sort(features.begin(), features.end());
+    }
+    return llvm::join(features, ",");
+}
 
+void CodeGenBase::emit(llvm::raw_pwrite_stream &dest, EmitKind kind,
+                       llvm::TargetMachine *target_machine) const {
+    std::unique_ptr<llvm::TargetMachine> own_target_machine;
+    if (target_machine == nullptr) {
+        own_target_machine = createTargetMachine(_opts);
+        target_machine = own_target_machine.get();
+    }
+    auto TheTargetMachine = target_machine;
+
+    (this->_ctx._module)->setTargetTriple(TheTargetMachine->getTargetTriple().str());
     (this->_ctx._module)->setDataLayout(TheTargetMachine->createDataLayout());
 
-    auto Filename = "output.S";
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(Filename, EC, llvm::sys::fs::OF_None);
+    optimize(*(this->_ctx._module), TheTargetMachine, _opts._opt_level);
 
-    if (EC) {
-        llvm::errs() << "Could not open file: " << EC.message();
+    PhaseTimer timer("emit", "Code Emission");
+    if (kind == EmitKind::LLVMIR) {
+        (this->_ctx._module)->print(dest, nullptr);
+        return;
+    }
+    if (kind == EmitKind::Bitcode) {
+        llvm::WriteBitcodeToFile(*(this->_ctx._module), dest);
+        return;
     }
 
     llvm::legacy::PassManager pass;
-    auto FileType = llvm::CodeGenFileType::AssemblyFile;
 
-    if (TheTargetMachine->addPassesToEmitFile(pass, dest, nullptr, FileType)) {
-        llvm::errs() << "TheTargetMachine can't emit a file of this type";
-        return ;
+    // ObjectFile goes through the integrated assembler, no textual round-trip
+    auto file_type = kind == EmitKind::Assembly ? llvm::CodeGenFileType::AssemblyFile
+                                                : llvm::CodeGenFileType::ObjectFile;
+    if (TheTargetMachine->addPassesToEmitFile(pass, dest, nullptr, file_type)) {
+        CodeGenContext::LogError("TheTargetMachine can't emit a file of this type");
     }
 
     pass.run(*(this->_ctx._module));
-    dest.flush();
 }
 
-llvm::Value *CodeGenBase::codeGenEntry(std::shared_ptr<ASTNode> node) {
-    auto entry_node = std::dynamic_pointer_cast<EntryNode>(node);
+llvm::Value *CodeGenBase::codeGenEntry(ASTNode *node) {
+    PhaseTimer timer("irgen", "IR Generation");
+    auto entry_node = dynamic_cast<EntryNode *>(node);
+    this->_ctx._symbols = entry_node->_symbols;
     // generate function declaration for standard library
     this->_ctx.codeGenStandardLibrary();
     this->codeGenProgram(entry_node->_prog);
-    this->_ctx._module->print(llvm::outs(), nullptr);
     return nullptr;
 }
 
-llvm::Value *CodeGenBase::codeGenProgram(std::shared_ptr<ASTNode> node) {
-    auto prog_node = std::dynamic_pointer_cast<ProgNode>(node);
+void CodeGenBase::printModule(llvm::raw_ostream &os) const {
+    this->_ctx._module->print(os, nullptr);
+}
 
-    if (prog_node->_prog) {
-        this->codeGenProgram(prog_node->_prog);
-    }
+llvm::orc::ThreadSafeModule CodeGenBase::takeModule(llvm::TargetMachine *target_machine) {
+    (this->_ctx._module)->setTargetTriple(target_machine->getTargetTriple().str());
+    (this->_ctx._module)->setDataLayout(target_machine->createDataLayout());
 
-    if (prog_node->_decl) {
-        this->codeGenDecl(prog_node->_decl);
-    }
+    this->_ctx._builder.reset();
+    return llvm::orc::ThreadSafeModule(std::move(this->_ctx._module), std::move(this->_ctx._context));
+}
+
+llvm::Value *CodeGenBase::codeGenProgram(ASTNode *node) {
+    auto prog_node = dynamic_cast<ProgNode *>(node);
+
+    for (auto item : prog_node->_items) {
+        auto item_node = dynamic_cast<ItemNode *>(item);
+        if (item_node->_decl) {
+            this->codeGenDecl(item_node->_decl);
+        }
+
+        if (item_node->_func) {
+            this->codeGenFunc(item_node->_func);
+        }
 
-    if (prog_node->_func) {
-        this->codeGenFunc(prog_node->_func);
+        if (item_node->_extern_decl) {
+            this->codeGenExternDecl(item_node->_extern_decl);
+        }
     }
 
     return nullptr;
 }
-llvm::Value *CodeGenBase::codeGenFunc(std::shared_ptr<ASTNode> node) {
-    auto func_node = std::dynamic_pointer_cast<FuncNode>(node);
-
-    if ((this->_ctx._module)->getFunction(func_node->_ident) != nullptr) {
-        CodeGenContext::LogError("function can't be redefined");
-    }
 
+llvm::FunctionType *CodeGenBase::getFuncType(llvm::StringRef type, FuncFParamsNode *params_node, std::vector<bool> &is_ptr_vec) const {
     // args type:  (int,int) etc.
-    auto func_params_node  = std::dynamic_pointer_cast<FuncFParamsNode>(func_node->_param);
-    int params_size = func_params_node->_params.size();
+    int params_size = params_node->_params.size();
     std::vector<llvm::Type *> types;
-    std::vector<bool> is_ptr_vec;
     for (int i = 0; i < params_size; ++i) {
-        auto func_param_node = std::dynamic_pointer_cast<FuncFParamNode>(func_params_node->_params[i]);
+        auto func_param_node = dynamic_cast<FuncFParamNode *>(params_node->_params[i]);
         if (func_param_node->_type == "int") {
             types.emplace_back(llvm::Type::getInt64Ty(*(this->_ctx._context)));
             is_ptr_vec.push_back(false);
@@ -102,20 +207,69 @@ llvm::Value *CodeGenBase::codeGenFunc(std::shared_ptr<ASTNode> node) {
         }
     }
 
-    llvm::FunctionType *ft;
-    if (func_node->_type == "int") {
-        ft = llvm::FunctionType::get(llvm::Type::getInt64Ty(*(this->_ctx._context)), types, false);
+    if (type == "int") {
+        return llvm::FunctionType::get(llvm::Type::getInt64Ty(*(this->_ctx._context)), types, false);
+    }
+    return llvm::FunctionType::get(llvm::Type::getVoidTy(*(this->_ctx._context)), types, false);
+}
+
+llvm::Value *CodeGenBase::codeGenExternDecl(ASTNode *node) {
+    auto extern_node = dynamic_cast<ExternDeclNode *>(node);
+
+    if (!extern_node->_is_func) {
+        llvm::Value *array_size = nullptr;
+        if (extern_node->_is_array) {
+            // extern int arr[]; is declared as [0 x i64], indexing doesn't need the real size
+            array_size = extern_node->_exp ? this->codeGenExp(extern_node->_exp) : this->getInitInt();
+        }
+        this->_ctx.declareGlobalValue(extern_node->_ident, llvm::Type::getInt64Ty(*(this->_ctx._context)), array_size);
+        return nullptr;
+    }
+
+    std::vector<bool> is_ptr_vec;
+    auto ft = this->getFuncType(extern_node->_type, dynamic_cast<FuncFParamsNode *>(extern_node->_param), is_ptr_vec);
+    llvm::Function *func = (this->_ctx._module)->getFunction(name(extern_node->_ident));
+    if (func != nullptr) {
+        // re-declaration is fine as long as the signature matches
+        if (func->getFunctionType() != ft) {
+            CodeGenContext::LogError("conflicting types for function: " + name(extern_node->_ident).str());
+        }
+        return func;
+    }
+    return llvm::Function::Create(ft, llvm::Function::ExternalLinkage, name(extern_node->_ident), (this->_ctx._module).get());
+}
+llvm::Value *CodeGenBase::codeGenFunc(ASTNode *node) {
+    auto func_node = dynamic_cast<FuncNode *>(node);
+    llvm::TimeTraceScope trace("CodeGenFunction", name(func_node->_ident));
+
+    auto func_params_node  = dynamic_cast<FuncFParamsNode *>(func_node->_param);
+    std::vector<bool> is_ptr_vec;
+    llvm::FunctionType *ft = this->getFuncType(func_node->_type, func_params_node, is_ptr_vec);
+
+    // a function declared by extern (or the standard library) can be defined once
+    llvm::Function *func = (this->_ctx._module)->getFunction(name(func_node->_ident));
+    if (func != nullptr) {
+        if (!func->isDeclaration()) {
+            CodeGenContext::LogError("function can't be redefined");
+        }
+        if (func->getFunctionType() != ft) {
+            CodeGenContext::LogError("conflicting types for function: " + name(func_node->_ident).str());
+        }
     } else {
-        ft = llvm::FunctionType::get(llvm::Type::getVoidTy(*(this->_ctx._context)), types, false);
+        func = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, name(func_node->_ident), (this->_ctx._module).get());
+    }
+
+    // let the optimizer's cost models see the real machine
+    func->addFnAttr("target-cpu", _opts._cpu);
+    if (!_opts._features.empty()) {
+        func->addFnAttr("target-features", _opts._features);
     }
-    llvm::Function *func =
-        llvm::Function::Create(ft, llvm::Function::ExternalLinkage, func_node->_ident, (this->_ctx._module).get());
 
     // set args ident
     int idx = 0;
     for (auto &arg : func->args()) {
-        auto func_param_node = std::dynamic_pointer_cast<FuncFParamNode>(func_params_node->_params[idx++]);
-        arg.setName(func_param_node->_ident);
+        auto func_param_node = dynamic_cast<FuncFParamNode *>(func_params_node->_params[idx++]);
+        arg.setName(name(func_param_node->_ident));
     }
 
     llvm::BasicBlock *BB = llvm::BasicBlock::Create(*(this->_ctx._context), "entry", func);
@@ -125,7 +279,9 @@ llvm::Value *CodeGenBase::codeGenFunc(std::shared_ptr<ASTNode> node) {
     this->_ctx.pushNamedValuesLayer();
     idx = 0;
     for (auto &arg : func->args()) {
-        (this->_ctx).defineValue(std::string(arg.getName()), L24Type::ValType::VAR, {&arg}, nullptr, is_ptr_vec[idx++]);
+        auto func_param_node = dynamic_cast<FuncFParamNode *>(func_params_node->_params[idx]);
+        (this->_ctx).defineValue(func_param_node->_ident, L24Type::ValType::VAR, {&arg}, nullptr, is_ptr_vec[idx]);
+        ++idx;
     }
 
     this->codeGenBlock(func_node->_block);
@@ -140,22 +296,8 @@ llvm::Value *CodeGenBase::codeGenFunc(std::shared_ptr<ASTNode> node) {
     this->_ctx.popNamedValuesLayer();
     return func;
 }
-llvm::Value *CodeGenBase::codeGenLVal(std::shared_ptr<ASTNode> node) {
-    auto l_val_node = std::dynamic_pointer_cast<LValNode>(node);
-    llvm::Value *sub_idx = nullptr;
-    if (l_val_node->_exp) {
-        sub_idx = this->codeGenExp(l_val_node->_exp);
-    }
-
-    llvm::Value *val = this->_ctx.getValue(l_val_node->_ident, L24Type::ValType::ANY, sub_idx);
-    if (val == nullptr) {
-        CodeGenContext::LogError("Ident: " + l_val_node->_ident + " hasn't been declared");
-    }
-    return val;
-}
-
-llvm::Value *CodeGenBase::codeGenBlock(std::shared_ptr<ASTNode> node) {
-    auto block_node = std::dynamic_pointer_cast<BlockNode>(node);
+llvm::Value *CodeGenBase::codeGenBlock(ASTNode *node) {
+    auto block_node = dynamic_cast<BlockNode *>(node);
 
     this->_ctx.pushNamedValuesLayer();
     for (const auto& blk_item_node : block_node->_block_items) {
@@ -164,8 +306,8 @@ llvm::Value *CodeGenBase::codeGenBlock(std::shared_ptr<ASTNode> node) {
     this->_ctx.popNamedValuesLayer();
     return nullptr;
 }
-llvm::Value *CodeGenBase::codeGenStmt(std::shared_ptr<ASTNode> node) {
-    auto stmt_node = std::dynamic_pointer_cast<StmtNode>(node);
+llvm::Value *CodeGenBase::codeGenStmt(ASTNode *node) {
+    auto stmt_node = dynamic_cast<StmtNode *>(node);
     if (stmt_node->_block != nullptr) {
         return this->codeGenBlock(stmt_node->_block);
     }
@@ -201,7 +343,7 @@ llvm::Value *CodeGenBase::codeGenStmt(std::shared_ptr<ASTNode> node) {
         return nullptr;
     }
 
-    if (stmt_node->_l_val.empty()) {
+    if (stmt_node->_l_val == NoSymbol) {
         return new_val;
     }
 
@@ -212,8 +354,8 @@ llvm::Value *CodeGenBase::codeGenStmt(std::shared_ptr<ASTNode> node) {
     this->_ctx.setValue(stmt_node->_l_val, L24Type::ValType::VAR, new_val, sub_idx);
     return new_val;
 }
-llvm::Value *CodeGenBase::codeGenIfStmt(std::shared_ptr<ASTNode> node) {
-    auto stmt_node = std::dynamic_pointer_cast<StmtNode>(node);
+llvm::Value *CodeGenBase::codeGenIfStmt(ASTNode *node) {
+    auto stmt_node = dynamic_cast<StmtNode *>(node);
     llvm::Value *cond = this->codeGenExp(stmt_node->_expr);
     if (cond == nullptr) {
         return nullptr;
@@ -267,8 +409,8 @@ llvm::Value *CodeGenBase::codeGenIfStmt(std::shared_ptr<ASTNode> node) {
     return nullptr;
 }
 
-llvm::Value *CodeGenBase::codeGenWhileStmt(std::shared_ptr<ASTNode> node) {
-    auto stmt_node = std::dynamic_pointer_cast<StmtNode>(node);
+llvm::Value *CodeGenBase::codeGenWhileStmt(ASTNode *node) {
+    auto stmt_node = dynamic_cast<StmtNode *>(node);
 
     llvm::Function *func = (this->_ctx._builder)->GetInsertBlock()->getParent();
     llvm::BasicBlock *loop_bb = llvm::BasicBlock::Create(*(this->_ctx._context), "loop_cond", func);
@@ -314,162 +456,105 @@ llvm::Value *CodeGenBase::codeGenWhileStmt(std::shared_ptr<ASTNode> node) {
     return nullptr;
 }
 
-llvm::Value *CodeGenBase::codeGenNumber(std::shared_ptr<ASTNode> node) {
-    auto number_node = std::dynamic_pointer_cast<NumberNode>(node);
-    return llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, number_node->_int_literal));
-}
-llvm::Value *CodeGenBase::codeGenExp(std::shared_ptr<ASTNode> node) {
-    auto expr_node = std::dynamic_pointer_cast<ExprNode>(node);
-    return this->codeGenLorExp(expr_node->_lor_expr);
-}
-llvm::Value *CodeGenBase::codeGenUnaryExp(std::shared_ptr<ASTNode> node) {
-    auto unary_node = std::dynamic_pointer_cast<UnaryExprNode>(node);
-    if (unary_node->_primary_expr) {
-        return this->codeGenPrimaryExp(unary_node->_primary_expr);
-    } else if (unary_node->_unary_expr && unary_node->_unary_op) {
-        std::string op =
-            std::dynamic_pointer_cast<UnaryOpNode>(unary_node->_unary_op)->_op;
-        llvm::Value *val = this->codeGenUnaryExp(unary_node->_unary_expr);
-        if (op == "+") {
-            return val;
-        } else if (op == "-") {
-            return (this->_ctx._builder)->CreateNeg(val, "unary_sub_tmp");
-        } else if (op == "!") {
-            llvm::Value *zero = llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, 0, false));
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpEQ(zero, val));
-        }
-    } else {
-        // function call
-        llvm::Function *func = (this->_ctx._module)->getFunction(unary_node->_func_ident);
-        if (func == nullptr) {
-            CodeGenContext::LogError("unknown function " + unary_node->_func_ident);
-        }
-
-        auto func_params_node = std::dynamic_pointer_cast<FuncRParamsNode>(unary_node->_func_r_params);
-        if (func->arg_size() != func_params_node->_exps.size()) {
-            CodeGenContext::LogError("Incorrect arguments number, expect "
-                                     + std::to_string(func->arg_size()) +
-                                     " get " + std::to_string(func_params_node->_exps.size()));
-        }
-
-        std::vector<llvm::Value *> args_v;
-        for (const auto & _exp : func_params_node->_exps) {
-            args_v.push_back(this->codeGenExp(_exp));
-        }
-        return (this->_ctx._builder)->CreateCall(func, args_v, "call_" + unary_node->_func_ident);
+llvm::Value *CodeGenBase::codeGenExp(ASTNode *node) {
+    auto expr_node = static_cast<ExprNode *>(node);
+    switch (expr_node->_kind) {
+    case ExprNode::Kind::Binary: return this->codeGenBinaryExp(node);
+    case ExprNode::Kind::Unary: return this->codeGenUnaryExp(node);
+    case ExprNode::Kind::Literal: return this->codeGenLiteral(node);
+    case ExprNode::Kind::VarRef: return this->codeGenVarRef(node);
+    case ExprNode::Kind::Call: return this->codeGenCall(node);
     }
     return nullptr;
 }
-
-llvm::Value *CodeGenBase::codeGenPrimaryExp(std::shared_ptr<ASTNode> node) {
-    auto prim_exp_node = std::dynamic_pointer_cast<PrimExprNode>(node);
-    if (prim_exp_node->_expr) {
-        return this->codeGenExp(prim_exp_node->_expr);
-    } else if (prim_exp_node->_number){
-        return this->codeGenNumber(prim_exp_node->_number);
-    } else if (prim_exp_node->_l_val) {
-        return this->codeGenLVal(prim_exp_node->_l_val);
+llvm::Value *CodeGenBase::codeGenBinaryExp(ASTNode *node) {
+    auto binary_node = static_cast<BinaryExprNode *>(node);
+    llvm::Value *lv = this->codeGenExp(binary_node->_lhs);
+    llvm::Value *rv = this->codeGenExp(binary_node->_rhs);
+    auto &builder = *(this->_ctx._builder);
+    switch (binary_node->_op) {
+    case BinaryOp::Or:
+        return this->booleanToInt(builder.CreateLogicalOr(this->intToBoolean(lv), this->intToBoolean(rv)));
+    case BinaryOp::And:
+        return this->booleanToInt(builder.CreateLogicalAnd(this->intToBoolean(lv), this->intToBoolean(rv)));
+    case BinaryOp::Eq: return this->booleanToInt(builder.CreateICmpEQ(lv, rv));
+    case BinaryOp::Ne: return this->booleanToInt(builder.CreateICmpNE(lv, rv));
+    case BinaryOp::Lt: return this->booleanToInt(builder.CreateICmpSLT(lv, rv));
+    case BinaryOp::Gt: return this->booleanToInt(builder.CreateICmpSGT(lv, rv));
+    case BinaryOp::Le: return this->booleanToInt(builder.CreateICmpSLE(lv, rv));
+    case BinaryOp::Ge: return this->booleanToInt(builder.CreateICmpSGE(lv, rv));
+    case BinaryOp::Add: return builder.CreateAdd(lv, rv, "add_temp");
+    case BinaryOp::Sub: return builder.CreateSub(lv, rv, "bin_sub_temp");
+    case BinaryOp::Mul: return builder.CreateMul(lv, rv, "mul_tmp");
+    case BinaryOp::Div: return builder.CreateSDiv(lv, rv, "div_tmp");
+    case BinaryOp::Rem: return builder.CreateSRem(lv, rv, "rem_tmp");
     }
     return nullptr;
 }
-llvm::Value *CodeGenBase::codeGenAddExp(std::shared_ptr<ASTNode> node) {
-    auto add_exp_node = std::dynamic_pointer_cast<AddExprNode>(node);
-    if (add_exp_node->_op != '\0') {
-        llvm::Value *lv = this->codeGenAddExp(add_exp_node->_add_expr);
-        llvm::Value *rv = this->codeGenMulExp(add_exp_node->_mul_expr) ;
-        switch (add_exp_node->_op) {
-        case '+':
-            return (this->_ctx._builder)->CreateAdd(lv, rv, "add_temp");
-        case '-':
-            return (this->_ctx._builder)->CreateSub(lv, rv, "bin_sub_temp");
-        }
-    }
-    return this->codeGenMulExp(add_exp_node->_mul_expr);
+llvm::Value *CodeGenBase::codeGenUnaryExp(ASTNode *node) {
+    auto unary_node = static_cast<UnaryExprNode *>(node);
+    llvm::Value *val = this->codeGenExp(unary_node->_operand);
+    if (unary_node->_op == UnaryOp::Neg) {
+        return (this->_ctx._builder)->CreateNeg(val, "unary_sub_tmp");
+    }
+    llvm::Value *zero = llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, 0, false));
+    return this->booleanToInt((this->_ctx._builder)->CreateICmpEQ(zero, val));
 }
-llvm::Value *CodeGenBase::codeGenMulExp(std::shared_ptr<ASTNode> node) {
-    auto mul_exp_node = std::dynamic_pointer_cast<MulExprNode>(node);
-    if (mul_exp_node->_op != '\0') {
-        llvm::Value *lv = this->codeGenMulExp(mul_exp_node->_mul_expr);
-        llvm::Value *rv = this->codeGenUnaryExp(mul_exp_node->_unary_expr);
-        switch(mul_exp_node->_op) {
-        case '*':
-            return (this->_ctx._builder)->CreateMul(lv, rv, "mul_tmp");
-        case '/':
-            return (this->_ctx._builder)->CreateSDiv(lv, rv, "div_tmp");
-        case '%':
-            return (this->_ctx._builder)->CreateSRem(lv, rv, "rem_tmp");
-        }
-    }
-    return this->codeGenUnaryExp(mul_exp_node->_unary_expr);
-}
-llvm::Value *CodeGenBase::codeGenLorExp(std::shared_ptr<ASTNode> node) {
-    auto lor_exp_node = std::dynamic_pointer_cast<LorExprNode>(node);
-    if (lor_exp_node->_land_expr && lor_exp_node->_lor_expr) {
-        llvm::Value *lv = this->intToBoolean(this->codeGenLorExp(lor_exp_node->_lor_expr));
-        llvm::Value *rv = this->intToBoolean(this->codeGenLandExp(lor_exp_node->_land_expr));
-        return this->booleanToInt((this->_ctx._builder)->CreateLogicalOr(lv, rv));
-    }
-    return this->codeGenLandExp(lor_exp_node->_land_expr);
-}
-llvm::Value *CodeGenBase::codeGenLandExp(std::shared_ptr<ASTNode> node) {
-    auto land_exp_node = std::dynamic_pointer_cast<LandExprNode>(node);
-    if (land_exp_node->_land_expr && land_exp_node->_eq_expr) {
-        llvm::Value *lv = this->intToBoolean(this->codeGenLandExp(land_exp_node->_land_expr));
-        llvm::Value *rv = this->intToBoolean(this->codeGenEqExp(land_exp_node->_eq_expr));
-        return this->booleanToInt((this->_ctx._builder)->CreateLogicalAnd(lv, rv));
-    }
-    return this->codeGenEqExp(land_exp_node->_eq_expr);
+llvm::Value *CodeGenBase::codeGenLiteral(ASTNode *node) {
+    auto literal_node = static_cast<LiteralNode *>(node);
+    return llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, literal_node->_int_literal, true));
 }
-llvm::Value *CodeGenBase::codeGenEqExp(std::shared_ptr<ASTNode> node) {
-    auto eq_exp_node = std::dynamic_pointer_cast<EqExprNode>(node);
-    if (eq_exp_node->_eq_expr && eq_exp_node->_rel_expr) {
-        llvm::Value *lv = this->codeGenEqExp(eq_exp_node->_eq_expr);
-        llvm::Value *rv = this->codeGenRelExp(eq_exp_node->_rel_expr);
-        if (eq_exp_node->op == "==") {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpEQ(lv, rv));
-        } else {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpNE(lv, rv));
-        }
+llvm::Value *CodeGenBase::codeGenVarRef(ASTNode *node) {
+    auto var_ref_node = static_cast<VarRefNode *>(node);
+    llvm::Value *sub_idx = nullptr;
+    if (var_ref_node->_exp) {
+        sub_idx = this->codeGenExp(var_ref_node->_exp);
+    }
+
+    llvm::Value *val = this->_ctx.getValue(var_ref_node->_ident, L24Type::ValType::ANY, sub_idx);
+    if (val == nullptr) {
+        CodeGenContext::LogError("Ident: " + name(var_ref_node->_ident).str() + " hasn't been declared");
     }
-    return this->codeGenRelExp(eq_exp_node->_rel_expr);
+    return val;
 }
-llvm::Value *CodeGenBase::codeGenRelExp(std::shared_ptr<ASTNode> node) {
-    auto rel_exp_node = std::dynamic_pointer_cast<RelExprNode>(node);
-    if (rel_exp_node->_rel_expr && rel_exp_node->_add_expr) {
-        llvm::Value *lv = this->codeGenRelExp(rel_exp_node->_rel_expr);
-        llvm::Value *rv = this->codeGenAddExp(rel_exp_node->_add_expr);
-
-        if (rel_exp_node->op == "<") {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpSLT(lv, rv));
-        } else if (rel_exp_node->op == ">") {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpSGT(lv, rv));
-        } else if (rel_exp_node->op == "<=") {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpSLE(lv, rv));
-        } else {
-            return this->booleanToInt((this->_ctx._builder)->CreateICmpSGE(lv, rv));
-        }
+llvm::Value *CodeGenBase::codeGenCall(ASTNode *node) {
+    auto call_node = static_cast<CallNode *>(node);
+    llvm::Function *func = (this->_ctx._module)->getFunction(name(call_node->_func_ident));
+    if (func == nullptr) {
+        CodeGenContext::LogError("unknown function " + name(call_node->_func_ident).str());
+    }
+
+    if (func->arg_size() != call_node->_args.size()) {
+        CodeGenContext::LogError("Incorrect arguments number, expect "
+                                 + std::to_string(func->arg_size()) +
+                                 " get " + std::to_string(call_node->_args.size()));
+    }
+
+    std::vector<llvm::Value *> args_v;
+    for (const auto &arg : call_node->_args) {
+        args_v.push_back(this->codeGenExp(arg));
     }
-    return this->codeGenAddExp(rel_exp_node->_add_expr);
+    return (this->_ctx._builder)->CreateCall(func, args_v, "call_" + name(call_node->_func_ident));
 }
-llvm::Value *CodeGenBase::codeGenBlockItem(std::shared_ptr<ASTNode> node) {
-    auto blk_item_node = std::dynamic_pointer_cast<BlockItemNode>(node);
+llvm::Value *CodeGenBase::codeGenBlockItem(ASTNode *node) {
+    auto blk_item_node = dynamic_cast<BlockItemNode *>(node);
     if (blk_item_node->_decl) {
         return this->codeGenDecl(blk_item_node->_decl);
     }
     return this->codeGenStmt(blk_item_node->_stmt);
 }
-llvm::Value *CodeGenBase::codeGenDecl(std::shared_ptr<ASTNode> node) {
-    auto decl_node = std::dynamic_pointer_cast<DeclNode>(node);
+llvm::Value *CodeGenBase::codeGenDecl(ASTNode *node) {
+    auto decl_node = dynamic_cast<DeclNode *>(node);
     if (decl_node->_const_decl) {
         return this->codeGenConstDecl(decl_node->_const_decl);
     }
     return this->codeGenVarDecl(decl_node->_var_decl);
 }
-llvm::Value *CodeGenBase::codeGenConstDecl(std::shared_ptr<ASTNode> node) {
-    auto const_decl_node = std::dynamic_pointer_cast<ConstDeclNode>(node);
+llvm::Value *CodeGenBase::codeGenConstDecl(ASTNode *node) {
+    auto const_decl_node = dynamic_cast<ConstDeclNode *>(node);
     for (const auto& const_def_ast_node : const_decl_node->_const_defs) {
         this->codeGenConstDef(const_def_ast_node);
-        auto const_def_node = std::dynamic_pointer_cast<ConstDefNode>(const_def_ast_node);
+        auto const_def_node = dynamic_cast<ConstDefNode *>(const_def_ast_node);
 //        llvm::Value *val = this->_ctx.getValue(const_def_node->_ident, L24Type::ValType::CONST);
 //        if (val == nullptr || !val->getType()->isIntOrIntVectorTy(64)) {
 //            CodeGenContext::LogError("const define: type violates");
@@ -477,9 +562,9 @@ llvm::Value *CodeGenBase::codeGenConstDecl(std::shared_ptr<ASTNode> node) {
     }
     return nullptr;
 }
-llvm::Value *CodeGenBase::codeGenConstDef(std::shared_ptr<ASTNode> node) {
-    auto const_def_node = std::dynamic_pointer_cast<ConstDefNode>(node);
-    auto init_val_node = std::dynamic_pointer_cast<InitValNode>(const_def_node->_init_val);
+llvm::Value *CodeGenBase::codeGenConstDef(ASTNode *node) {
+    auto const_def_node = dynamic_cast<ConstDefNode *>(node);
+    auto init_val_node = dynamic_cast<InitValNode *>(const_def_node->_init_val);
 
     // array
     if (const_def_node->_exp != nullptr) {
@@ -491,11 +576,11 @@ llvm::Value *CodeGenBase::codeGenConstDef(std::shared_ptr<ASTNode> node) {
     return nullptr;
 }
 
-llvm::Value *CodeGenBase::codeGenVarDecl(std::shared_ptr<ASTNode> node) {
-    auto var_decl_node = std::dynamic_pointer_cast<VarDeclNode>(node);
+llvm::Value *CodeGenBase::codeGenVarDecl(ASTNode *node) {
+    auto var_decl_node = dynamic_cast<VarDeclNode *>(node);
     for (const auto& var_def_ast_node : var_decl_node->_var_defs) {
         this->codeGenVarDef(var_def_ast_node);
-        auto var_def_node = std::dynamic_pointer_cast<VarDefNode>(var_def_ast_node);
+        auto var_def_node = dynamic_cast<VarDefNode *>(var_def_ast_node);
 //        llvm::Value *val = this->_ctx.getValue(var_def_node->_ident, L24Type::ValType::VAR);
 //        if (val == nullptr || !val->getType()->isIntOrIntVectorTy(64)) {
 //            CodeGenContext::LogError("var define: type violates");
@@ -503,9 +588,9 @@ llvm::Value *CodeGenBase::codeGenVarDecl(std::shared_ptr<ASTNode> node) {
     }
     return nullptr;
 }
-llvm::Value *CodeGenBase::codeGenVarDef(std::shared_ptr<ASTNode> node) {
-    auto var_def_node = std::dynamic_pointer_cast<VarDefNode>(node);
-    auto init_val_node = std::dynamic_pointer_cast<InitValNode>(var_def_node->_init_val);
+llvm::Value *CodeGenBase::codeGenVarDef(ASTNode *node) {
+    auto var_def_node = dynamic_cast<VarDefNode *>(node);
+    auto init_val_node = dynamic_cast<InitValNode *>(var_def_node->_init_val);
 
     // array
     if (var_def_node->_exp != nullptr) {
@@ -517,7 +602,7 @@ llvm::Value *CodeGenBase::codeGenVarDef(std::shared_ptr<ASTNode> node) {
     return nullptr;
 }
 
-std::vector<llvm::Value*> CodeGenBase::getInitVals(std::shared_ptr<InitValNode> node, llvm::Value *array_size) {
+std::vector<llvm::Value*> CodeGenBase::getInitVals(InitValNode *node, llvm::Value *array_size) {
     int64_t size = 1;
     if (array_size != nullptr) {
         size = llvm::dyn_cast<llvm::ConstantInt>(array_size)->getSExtValue();
@@ -13,6 +13,7 @@
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/FileSystem.h"
 
@@ -21,42 +22,41 @@
 
 #include "llvm/TargetParser/Host.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
 
 
 #include "frontend/ast.h"
 #include "backend/code_gen_ctx.h"
+#include "backend/code_gen_opts.h"
 
 namespace l24 {
 
 class CodeGen {
 public:
-    virtual llvm::Value *codeGenEntry(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenProgram(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenFunc(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenBlock(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenStmt(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenAddExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenMulExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenUnaryExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenPrimaryExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenNumber(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenLorExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenLandExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenEqExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenRelExp(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenBlockItem(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenDecl(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenConstDecl(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenVarDecl(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenConstDef(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenVarDef(std::shared_ptr<ASTNode> node) = 0;
-    virtual llvm::Value *codeGenLVal(std::shared_ptr<ASTNode> node) = 0;
+    virtual llvm::Value *codeGenEntry(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenProgram(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenFunc(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenExternDecl(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenBlock(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenStmt(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenExp(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenBinaryExp(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenUnaryExp(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenLiteral(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenVarRef(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenCall(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenBlockItem(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenDecl(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenConstDecl(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenVarDecl(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenConstDef(ASTNode *node) = 0;
+    virtual llvm::Value *codeGenVarDef(ASTNode *node) = 0;
 };
 
 class CodeGenBase : public CodeGen {
 private:
     CodeGenContext _ctx;
+    CodeGenOptions _opts;
     llvm::Value *intToBoolean(llvm::Value *val) const {
         llvm::Value *zero = llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, 0, false));
         return (this->_ctx._builder)->CreateICmpNE(zero, val);
@@ -65,39 +65,66 @@ private:
         return (this->_ctx._builder)->CreateIntCast(val, llvm::Type::getInt64Ty(*(this->_ctx._context)), false);
     }
 
+    llvm::StringRef name(Symbol ident) const {
+        return this->_ctx._symbols->name(ident);
+    }
+
     llvm::Value *getInitInt() const {
         return llvm::ConstantInt::get(*(this->_ctx._context), llvm::APInt(64, 0, false));
     }
 
-    std::vector<llvm::Value*> getInitVals(std::shared_ptr<InitValNode> node, llvm::Value *array_size = nullptr);
+    llvm::FunctionType *getFuncType(llvm::StringRef type, FuncFParamsNode *params_node, std::vector<bool> &is_ptr_vec) const;
+
+    std::vector<llvm::Value*> getInitVals(InitValNode *node, llvm::Value *array_size = nullptr);
 
 public:
-    void asmGen() const;
-
-    llvm::Value *codeGenEntry(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenLorExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenLandExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenEqExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenRelExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenUnaryExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenAddExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenBlockItem(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenDecl(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenConstDecl(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenConstDef(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenLVal(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenMulExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenPrimaryExp(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenProgram(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenFunc(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenBlock(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenStmt(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenNumber(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenVarDecl(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenVarDef(std::shared_ptr<ASTNode> node) override;
-    llvm::Value *codeGenIfStmt(std::shared_ptr<ASTNode> node);
-    llvm::Value *codeGenWhileStmt(std::shared_ptr<ASTNode> node);
+    explicit CodeGenBase(const CodeGenOptions &opts = CodeGenOptions()): _opts(opts) {}
+
+    // initialize all targets of the registry, safe to call from any thread
+    static void initTargets();
+
+    static llvm::CodeGenOptLevel getCodeGenOptLevel(unsigned opt_level);
+
+    // run the new pass manager pipeline that matches opt_level (0 ~ 3) on module
+    static void optimize(llvm::Module &module, llvm::TargetMachine *target_machine, unsigned opt_level);
+
+    // TargetMachine for the default triple and the cpu/features/opt level of opts
+    static std::unique_ptr<llvm::TargetMachine> createTargetMachine(const CodeGenOptions &opts);
+
+    // feature string of every feature the host cpu has (or lacks), for -march=native
+    static std::string getHostFeatures();
+
+    // optimize the module and emit it as IR, bitcode, assembly or object code (through
+    // the integrated assembler), failures are reported by CodeGenError.
+    // target_machine must match the options of this CodeGenBase, one is created if null
+    void emit(llvm::raw_pwrite_stream &dest, EmitKind kind,
+              llvm::TargetMachine *target_machine = nullptr) const;
+    void printModule(llvm::raw_ostream &os) const;
+
+    // prepare the module for target_machine and move it out unoptimized (for the JIT),
+    // nothing can be generated or emitted afterwards
+    llvm::orc::ThreadSafeModule takeModule(llvm::TargetMachine *target_machine);
+
+    llvm::Value *codeGenEntry(ASTNode *node) override;
+    llvm::Value *codeGenExp(ASTNode *node) override;
+    llvm::Value *codeGenBinaryExp(ASTNode *node) override;
+    llvm::Value *codeGenUnaryExp(ASTNode *node) override;
+    llvm::Value *codeGenLiteral(ASTNode *node) override;
+    llvm::Value *codeGenVarRef(ASTNode *node) override;
+    llvm::Value *codeGenCall(ASTNode *node) override;
+    llvm::Value *codeGenBlockItem(ASTNode *node) override;
+    llvm::Value *codeGenDecl(ASTNode *node) override;
+    llvm::Value *codeGenConstDecl(ASTNode *node) override;
+    llvm::Value *codeGenConstDef(ASTNode *node) override;
+    llvm::Value *codeGenProgram(ASTNode *node) override;
+    llvm::Value *codeGenFunc(ASTNode *node) override;
+    llvm::Value *codeGenExternDecl(ASTNode *node) override;
+    llvm::Value *codeGenBlock(ASTNode *node) override;
+    llvm::Value *codeGenStmt(ASTNode *node) override;
+    llvm::Value *codeGenVarDecl(ASTNode *node) override;
+    llvm::Value *codeGenVarDef(ASTNode *node) override;
+    llvm::Value *codeGenIfStmt(ASTNode *node);
+    llvm::Value *codeGenWhileStmt(ASTNode *node);
 };
 
 
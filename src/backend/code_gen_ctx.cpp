@@ -12,8 +12,7 @@ CodeGenContext::CodeGenContext() {
 }
 
 void CodeGenContext::LogError(const std::string &str) {
-    std::cerr << "Error: " << str << std::endl;
-    exit(1);
+    throw CodeGenError(str);
 }
 
 void CodeGenContext::pushNamedValuesLayer() {
@@ -24,7 +23,7 @@ void CodeGenContext::popNamedValuesLayer() {
     _nested_named_values.pop_back();
 }
 
-void CodeGenContext::defineValue(const std::string &ident, L24Type::ValType ty, std::vector<llvm::Value*>vals, llvm::Value *array_size, bool is_ptr)  {
+void CodeGenContext::defineValue(Symbol ident, L24Type::ValType ty, std::vector<llvm::Value*>vals, llvm::Value *array_size, bool is_ptr)  {
     assert(ty == L24Type::ValType::CONST || ty == L24Type::ValType::VAR);
 
     // this var/const is a global var/const
@@ -37,8 +36,8 @@ void CodeGenContext::defineValue(const std::string &ident, L24Type::ValType ty,
 
     if (named_values.count(ident) == 0) {
         switch (ty) {
-        case L24Type::ValType::CONST: named_values[ident] = L24Type::ConstVal(this->createDefineValueInst(vals, ident, array_size, is_ptr)); break;
-        case L24Type::ValType::VAR: named_values[ident] = L24Type::VarVal(this->createDefineValueInst(vals, ident, array_size, is_ptr)); break;
+        case L24Type::ValType::CONST: named_values[ident] = L24Type::ConstVal(this->createDefineValueInst(vals, name(ident), array_size, is_ptr)); break;
+        case L24Type::ValType::VAR: named_values[ident] = L24Type::VarVal(this->createDefineValueInst(vals, name(ident), array_size, is_ptr)); break;
         default: LogError("you must specify var/const of this ident");
         }
     } else {
@@ -46,7 +45,7 @@ void CodeGenContext::defineValue(const std::string &ident, L24Type::ValType ty,
     }
 }
 
-void CodeGenContext::setValue(const std::string &ident, L24Type::ValType ty, llvm::Value *val, llvm::Value *sub_idx) {
+void CodeGenContext::setValue(Symbol ident, L24Type::ValType ty, llvm::Value *val, llvm::Value *sub_idx) {
     assert(ty == L24Type::ValType::CONST || ty == L24Type::ValType::VAR);
 
     int valid_layer = getCurrentLayer();
@@ -65,8 +64,8 @@ void CodeGenContext::setValue(const std::string &ident, L24Type::ValType ty, llv
 
     if (named_values.count(ident) == 0) {
         switch (ty) {
-        case L24Type::ValType::CONST: named_values[ident] = L24Type::ConstVal(this->createDefineValueInst({val}, ident)); break;
-        case L24Type::ValType::VAR: named_values[ident] = L24Type::VarVal(this->createDefineValueInst({val}, ident)); break;
+        case L24Type::ValType::CONST: named_values[ident] = L24Type::ConstVal(this->createDefineValueInst({val}, name(ident))); break;
+        case L24Type::ValType::VAR: named_values[ident] = L24Type::VarVal(this->createDefineValueInst({val}, name(ident))); break;
         default: LogError("you must specify var/const of this ident");
         }
         return;
@@ -75,10 +74,10 @@ void CodeGenContext::setValue(const std::string &ident, L24Type::ValType ty, llv
     assert(ty == L24Type::ValType::VAR);
     try {
         this->createSetValueInst(std::get<L24Type::VarVal>(named_values[ident])._val, val, sub_idx);
-    } catch (std::bad_variant_access const &ex) { LogError(ident + " is a const"); }
+    } catch (std::bad_variant_access const &ex) { LogError(name(ident).str() + " is a const"); }
 }
 
-llvm::Value *CodeGenContext::getValue(const std::string &ident, L24Type::ValType ty, llvm::Value *sub_idx) {
+llvm::Value *CodeGenContext::getValue(Symbol ident, L24Type::ValType ty, llvm::Value *sub_idx) {
     int valid_layer = getCurrentLayer();
     for (; valid_layer >= 0; --valid_layer) {
         const auto &named_values = getNamedValues(valid_layer);
@@ -95,8 +94,8 @@ llvm::Value *CodeGenContext::getValue(const std::string &ident, L24Type::ValType
     const auto &var_val = named_values[ident];
     try {
         switch (ty) {
-        case L24Type::ValType::VAR: return this->createGetValueInst(std::get<L24Type::VarVal>(var_val)._val, ident, sub_idx);
-        default: return this->createGetValueInst(std::get<L24Type::ConstVal>(var_val)._val, ident, sub_idx);
+        case L24Type::ValType::VAR: return this->createGetValueInst(std::get<L24Type::VarVal>(var_val)._val, name(ident), sub_idx);
+        default: return this->createGetValueInst(std::get<L24Type::ConstVal>(var_val)._val, name(ident), sub_idx);
         }
     } catch (std::bad_variant_access const &ex) {
         switch (ty) {
@@ -107,13 +106,13 @@ llvm::Value *CodeGenContext::getValue(const std::string &ident, L24Type::ValType
             LogError(std::string(ex.what()) + ": contained const, not var");
             break;
         case L24Type::ValType::ANY:
-            return this->createGetValueInst(std::get<L24Type::VarVal>(var_val)._val, ident, sub_idx);
+            return this->createGetValueInst(std::get<L24Type::VarVal>(var_val)._val, name(ident), sub_idx);
         }
     }
     return nullptr;
 }
 
-bool CodeGenContext::inCurrentLayer(const std::string &ident) {
+bool CodeGenContext::inCurrentLayer(Symbol ident) {
     return getNamedValues(getCurrentLayer()).count(ident) != 0;
 }
 
@@ -183,37 +182,59 @@ void CodeGenContext::codeGenStandardLibrary() const {
         llvm::FunctionType::get(void_ty, {int64ptr_ty, int64_ty, int64_ty, int64ptr_ty}, false);
     llvm::Function::Create(ft_plus_str_num, llvm::Function::ExternalLinkage, "plusStrNum", _module.get());
 }
-void CodeGenContext::defineGlobalValue(const std::string &ident, llvm::Type *ty, std::vector<llvm::Value *>vals, llvm::Value *array_size) {
-    if (_module->getGlobalVariable(ident) != nullptr) {
-        CodeGenContext::LogError("redefine global var/const: " + ident);
+void CodeGenContext::declareGlobalValue(Symbol ident, llvm::Type *ty, llvm::Value *array_size) {
+    llvm::Type *value_ty = ty;
+    if (array_size != nullptr) {
+        value_ty = llvm::ArrayType::get(ty, llvm::dyn_cast<llvm::ConstantInt>(array_size)->getSExtValue());
     }
 
+    // an extern declaration of an already declared/defined global is a no-op
+    if (_globals.count(ident) != 0) {
+        return;
+    }
+    _globals[ident] = new llvm::GlobalVariable(*_module, value_ty, false, llvm::GlobalValue::ExternalLinkage, nullptr, name(ident));
+}
+
+void CodeGenContext::defineGlobalValue(Symbol ident, llvm::Type *ty, std::vector<llvm::Value *>vals, llvm::Value *array_size) {
+    // an extern declaration of the same global may come first
+    llvm::GlobalVariable *decl = _globals.lookup(ident);
+    if (decl != nullptr && !decl->isDeclaration()) {
+        CodeGenContext::LogError("redefine global var/const: " + name(ident).str());
+    }
+
+    llvm::Type *value_ty = ty;
+    llvm::Constant *init;
     if (array_size == nullptr) {
-        _module->getOrInsertGlobal(ident, ty);
-        auto constantInt =
-            llvm::ConstantInt::getIntegerValue(ty,llvm::APInt(64, (llvm::dyn_cast<llvm::ConstantInt>(vals[0])->getSExtValue())));
-        _module->getGlobalVariable(ident)->setInitializer(constantInt);
+        init = llvm::ConstantInt::getIntegerValue(ty,llvm::APInt(64, (llvm::dyn_cast<llvm::ConstantInt>(vals[0])->getSExtValue())));
     } else {
         // array
         auto size = llvm::dyn_cast<llvm::ConstantInt>(array_size)->getSExtValue();
         auto array_type = llvm::ArrayType::get(ty, size);
-        _module->getOrInsertGlobal(ident, array_type);
+        value_ty = array_type;
 
         std::vector<llvm::Constant*> init_vals_vec;
         for (int64_t i = 0; i < size; ++i)  {
             init_vals_vec.push_back(llvm::ConstantInt::getIntegerValue(ty,llvm::APInt(64, (llvm::dyn_cast<llvm::ConstantInt>(vals[i])->getSExtValue()))));
         }
-        llvm::Constant* init = llvm::ConstantArray::get(array_type, init_vals_vec);
-        _module->getGlobalVariable(ident)->setInitializer(init);
+        init = llvm::ConstantArray::get(array_type, init_vals_vec);
+    }
+
+    auto global = new llvm::GlobalVariable(*_module, value_ty, false, llvm::GlobalValue::ExternalLinkage, init, name(ident));
+    _globals[ident] = global;
+    if (decl != nullptr) {
+        // the declaration may have another (unsized array) type, so replace it
+        global->takeName(decl);
+        decl->replaceAllUsesWith(global);
+        decl->eraseFromParent();
     }
 }
 
-void CodeGenContext::setGlobalValue(const std::string &ident, llvm::Value *val, llvm::Value *sub_idx) {
-    if (_module->getGlobalVariable(ident) == nullptr) {
-        CodeGenContext::LogError("global var/const: " + ident + " doesn't exist");
+void CodeGenContext::setGlobalValue(Symbol ident, llvm::Value *val, llvm::Value *sub_idx) {
+    llvm::GlobalVariable* key = _globals.lookup(ident);
+    if (key == nullptr) {
+        CodeGenContext::LogError("global var/const: " + name(ident).str() + " doesn't exist");
     }
 
-    llvm::GlobalVariable* key = _module->getGlobalVariable(ident);
     llvm::Type *ty = key->getValueType();
 
     // scalar
@@ -233,34 +254,44 @@ void CodeGenContext::setGlobalValue(const std::string &ident, llvm::Value *val,
 
     // array
     // we don't support struct, so the first value of indexList always be 0
-    auto first_val = llvm::ConstantInt::get(ty, 0);
+    auto first_val = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*_context), 0);
     llvm::Value* indexList[2] = {first_val, sub_idx};
     auto ptr = this->_builder->CreateGEP(key->getValueType(), key, indexList);
     this->_builder->CreateStore(val, ptr);
 }
 
 
-llvm::Value *CodeGenContext::getGlobalValue(const std::string &ident, llvm::Value* sub_idx) {
-    if (_module->getGlobalVariable(ident) == nullptr) {
-        CodeGenContext::LogError("global var/const: " + ident + " doesn't exist");
+llvm::Value *CodeGenContext::getGlobalValue(Symbol ident, llvm::Value* sub_idx) {
+    llvm::GlobalVariable* key = _globals.lookup(ident);
+    if (key == nullptr) {
+        CodeGenContext::LogError("global var/const: " + name(ident).str() + " doesn't exist");
     }
-    llvm::GlobalVariable* key = _module->getGlobalVariable(ident);
     llvm::Type *ty = key->getValueType();
 
+    auto int64_ty = llvm::Type::getInt64Ty(*_context);
+    // we don't support struct, so the first value of indexList always be 0
+    auto first_val = llvm::ConstantInt::get(int64_ty, 0);
+
     // scalar
     if (sub_idx == nullptr) {
         // get var/const in global domain
         if (_nested_named_values.empty()) {
+            if (key->isDeclaration()) {
+                CodeGenContext::LogError("extern global var/const: " + name(ident).str() + " isn't a constant");
+            }
             return key->getInitializer();
         }
+        // this is actually an array, passed to a function as a pointer
+        if (llvm::isa<llvm::ArrayType>(ty)) {
+            llvm::Value* indexList[2] = {first_val, first_val};
+            return this->_builder->CreateGEP(ty, key, indexList);
+        }
         return _builder->CreateLoad(ty, key);
     }
 
-    // we don't support struct, so the first value of indexList always be 0
-    auto first_val = llvm::ConstantInt::get(ty, 0);
     llvm::Value* indexList[2] = {first_val, sub_idx};
     auto ptr = this->_builder->CreateGEP(key->getValueType(), key, indexList);
-    return this->_builder->CreateLoad(ty, ptr);
+    return this->_builder->CreateLoad(int64_ty, ptr);
 }
 
 } // namespace l24
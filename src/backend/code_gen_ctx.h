@@ -1,27 +1,41 @@
 #pragma once
 
-#include <map>
+#include <variant>
+#include <stdexcept>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 
+#include "frontend/symbol_table.h"
 #include "frontend/type.h"
 
 namespace l24 {
+// thrown by CodeGenContext::LogError, so a bad input only fails its own compilation
+class CodeGenError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 class CodeGenContext {
 private:
-    std::map<std::string, std::variant<L24Type::ConstVal, L24Type::VarVal>> &getNamedValues(int layer) {
+    llvm::DenseMap<Symbol, std::variant<L24Type::ConstVal, L24Type::VarVal>> &getNamedValues(int layer) {
         return _nested_named_values[layer];
     }
 
+    llvm::StringRef name(Symbol ident) const {
+        return _symbols->name(ident);
+    }
+
     int getCurrentLayer() const {
         return static_cast<int>(_nested_named_values.size()) - 1;
     }
 
-    llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Function *func, const std::string &var_name, llvm::Value *array_size = nullptr, bool is_ptr = false) {
+    llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Function *func, llvm::StringRef var_name, llvm::Value *array_size = nullptr, bool is_ptr = false) {
         llvm::IRBuilder<> TmpB(&func->getEntryBlock(),
                                func->getEntryBlock().begin());
         llvm::Type *ty;
@@ -38,7 +52,7 @@ private:
         return TmpB.CreateAlloca(llvm::ArrayType::get(ty, size), array_size,var_name);
     }
 
-    llvm::AllocaInst *createDefineValueInst(std::vector<llvm::Value *>vals, const std::string &ident, llvm::Value *array_size = nullptr, bool is_ptr = false) {
+    llvm::AllocaInst *createDefineValueInst(std::vector<llvm::Value *>vals, llvm::StringRef ident, llvm::Value *array_size = nullptr, bool is_ptr = false) {
         llvm::AllocaInst *alloca = this->CreateEntryBlockAlloca((this->_builder)->GetInsertBlock()->getParent(), ident, array_size, is_ptr);
         // scalar
         if (array_size == nullptr) {
@@ -86,7 +100,7 @@ private:
         this->_builder->CreateStore(val, ptr);
     }
 
-    llvm::Value *createGetValueInst(llvm::AllocaInst *alloca, const std::string &ident, llvm::Value *sub_idx) const {
+    llvm::Value *createGetValueInst(llvm::AllocaInst *alloca, llvm::StringRef ident, llvm::Value *sub_idx) const {
         // get a scalar value
         if (sub_idx == nullptr) {
 
@@ -98,7 +112,7 @@ private:
                 llvm::Value* indexList[2] = {llvm::ConstantInt::get(ty, 0), llvm::ConstantInt::get(ty, 0)};
                 return this->_builder->CreateGEP(alloca->getAllocatedType(), alloca, indexList);
             }
-            return this->_builder->CreateLoad(alloca->getAllocatedType(), alloca, ident.c_str());
+            return this->_builder->CreateLoad(alloca->getAllocatedType(), alloca, ident);
         }
 
         // get value from an array
@@ -115,7 +129,7 @@ private:
         } else {
             ptr = this->_builder->CreateGEP(alloca_ty, alloca, indexList);
         }
-        return this->_builder->CreateLoad(ty, ptr, ident.c_str());
+        return this->_builder->CreateLoad(ty, ptr, ident);
     }
 
 
@@ -126,8 +140,14 @@ public:
     std::unique_ptr<llvm::Module> _module;
     std::unique_ptr<llvm::IRBuilder<>> _builder;
 
+    // names of the Symbols passed to the methods below
+    const SymbolTable *_symbols = nullptr;
+
+    // globals defined/declared by the module, by name
+    llvm::DenseMap<Symbol, llvm::GlobalVariable *> _globals;
+
     // used by find var/const
-    std::vector<std::map<std::string, std::variant<L24Type::ConstVal, L24Type::VarVal>>> _nested_named_values;
+    std::vector<llvm::DenseMap<Symbol, std::variant<L24Type::ConstVal, L24Type::VarVal>>> _nested_named_values;
 
     // used by continue/break to generate unconditional branch instruction
     // first is loop block (continue)
@@ -136,17 +156,19 @@ public:
 
 
     CodeGenContext();
-    static void LogError(const std::string &str);
+    [[noreturn]] static void LogError(const std::string &str);
     void codeGenStandardLibrary() const;
     void pushNamedValuesLayer();
     void popNamedValuesLayer();
-    void defineValue(const std::string &ident, L24Type::ValType ty, std::vector<llvm::Value*> vals, llvm::Value *array_size = nullptr, bool is_ptr = false);
-    void setValue(const std::string &ident, L24Type::ValType ty, llvm::Value *val, llvm::Value *sub_idx = nullptr);
-    llvm::Value *getValue(const std::string &ident, L24Type::ValType ty, llvm::Value *sub_idx = nullptr);
-    bool inCurrentLayer(const std::string &ident);
-    void defineGlobalValue(const std::string &ident, llvm::Type *ty, std::vector<llvm::Value*> vals, llvm::Value *array_size = nullptr);
-    void setGlobalValue(const std::string &ident, llvm::Value* val, llvm::Value *sub_idx = nullptr);
-    llvm::Value *getGlobalValue(const std::string &ident, llvm::Value *sub_idx = nullptr);
+    void defineValue(Symbol ident, L24Type::ValType ty, std::vector<llvm::Value*> vals, llvm::Value *array_size = nullptr, bool is_ptr = false);
+    void setValue(Symbol ident, L24Type::ValType ty, llvm::Value *val, llvm::Value *sub_idx = nullptr);
+    llvm::Value *getValue(Symbol ident, L24Type::ValType ty, llvm::Value *sub_idx = nullptr);
+    bool inCurrentLayer(Symbol ident);
+    // extern var/const defined in another translation unit, array_size may be 0
+    void declareGlobalValue(Symbol ident, llvm::Type *ty, llvm::Value *array_size = nullptr);
+    void defineGlobalValue(Symbol ident, llvm::Type *ty, std::vector<llvm::Value*> vals, llvm::Value *array_size = nullptr);
+    void setGlobalValue(Symbol ident, llvm::Value* val, llvm::Value *sub_idx = nullptr);
+    llvm::Value *getGlobalValue(Symbol ident, llvm::Value *sub_idx = nullptr);
 };
 
 } // namespace l24
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+namespace l24 {
+
+// what the backend writes for a module
+enum class EmitKind {
+    Assembly,
+    Object,
+    // textual IR (.ll)
+    LLVMIR,
+    Bitcode,
+};
+
+// options that control how the backend optimizes and emits a module
+struct CodeGenOptions {
+    // IR optimization level, same meaning as -O0 ~ -O3 of clang
+    unsigned _opt_level = 0;
+    // target cpu and feature string (eg: "+avx2,-avx512f") passed to the TargetMachine,
+    // also stamped on every function as "target-cpu"/"target-features"
+    std::string _cpu = "generic";
+    std::string _features;
+};
+
+} // namespace l24
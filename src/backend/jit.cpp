@@ -0,0 +1,332 @@
+#include <mutex>
+
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/Error.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#include "backend/jit.h"
+#include "runtime/sysy.h"
+
+namespace l24 {
+
+static constexpr const char *TierUpCallbackName = "l24.tier_up";
+static constexpr const char *TierUpJITName = "l24.tier_up.jit";
+
+template <typename T>
+static T unwrap(llvm::Expected<T> value) {
+    if (!value) {
+        CodeGenContext::LogError(llvm::toString(value.takeError()));
+    }
+    return std::move(*value);
+}
+
+static void check(llvm::Error err) {
+    if (err) {
+        CodeGenContext::LogError(llvm::toString(std::move(err)));
+    }
+}
+
+namespace {
+// Compiles the IR modules of the JIT. The object cache is asked before the optimization
+// pipeline runs, so a hit skips both optimization and codegen.
+class OptimizingCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+public:
+    OptimizingCompiler(std::unique_ptr<llvm::TargetMachine> target_machine, unsigned opt_level,
+                       llvm::ObjectCache *cache):
+        IRCompiler(llvm::orc::irManglingOptionsFromTargetOptions(target_machine->Options)),
+        _target_machine(std::move(target_machine)), _opt_level(opt_level), _cache(cache) {}
+
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module &module) override {
+        // a TargetMachine can't be used by several threads at once
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_cache != nullptr) {
+            if (auto object = _cache->getObject(&module)) {
+                return std::move(object);
+            }
+        }
+        CodeGenBase::optimize(module, _target_machine.get(), _opt_level);
+        auto object = llvm::orc::SimpleCompiler(*_target_machine)(module);
+        if (object && _cache != nullptr) {
+            _cache->notifyObjectCompiled(&module, (*object)->getMemBufferRef());
+        }
+        return object;
+    }
+
+private:
+    std::unique_ptr<llvm::TargetMachine> _target_machine;
+    unsigned _opt_level;
+    llvm::ObjectCache *_cache;
+    std::mutex _mutex;
+};
+} // namespace
+
+// everything besides the module itself that changes the generated object
+static std::string getCacheConfig(const llvm::orc::JITTargetMachineBuilder &jtmb, unsigned opt_level) {
+    return jtmb.getTargetTriple().str() + " " + jtmb.getCPU() + " " + jtmb.getFeatures().getString() +
+           " O" + std::to_string(opt_level);
+}
+
+JIT::JIT(const CodeGenOptions &opts, const JITOptions &jit_opts):
+    _opts(opts), _jit_opts(jit_opts), _self(reinterpret_cast<int64_t>(this)) {
+    CodeGenBase::initTargets();
+    // baseline code is compiled as fast as possible, hot functions get -O3 later
+    bool tiered = _jit_opts._tier_up_threshold != 0;
+    if (tiered) {
+        _opts._opt_level = 0;
+    }
+
+    auto jtmb = unwrap(llvm::orc::JITTargetMachineBuilder::detectHost());
+    jtmb.setCPU(_opts._cpu);
+    jtmb.getFeatures() = llvm::SubtargetFeatures(_opts._features);
+    if (tiered) {
+        auto tier_up_jtmb = jtmb;
+        tier_up_jtmb.setCodeGenOptLevel(CodeGenBase::getCodeGenOptLevel(3));
+        if (!_jit_opts._cache_dir.empty()) {
+            _tier_up_object_cache = std::make_unique<JITObjectCache>(
+                _jit_opts._cache_dir, getCacheConfig(tier_up_jtmb, 3));
+        }
+        _tier_up_compiler = std::make_unique<OptimizingCompiler>(
+            unwrap(tier_up_jtmb.createTargetMachine()), 3, _tier_up_object_cache.get());
+    }
+    jtmb.setCodeGenOptLevel(CodeGenBase::getCodeGenOptLevel(_opts._opt_level));
+    if (!_jit_opts._cache_dir.empty()) {
+        _object_cache = std::make_unique<JITObjectCache>(_jit_opts._cache_dir,
+                                                         getCacheConfig(jtmb, _opts._opt_level));
+    }
+    _target_machine = unwrap(jtmb.createTargetMachine());
+
+    unsigned opt_level = _opts._opt_level;
+    JITObjectCache *cache = _object_cache.get();
+    _jit = unwrap(llvm::orc::LLJITBuilder()
+                      .setJITTargetMachineBuilder(std::move(jtmb))
+                      .setCompileFunctionCreator([opt_level, cache](llvm::orc::JITTargetMachineBuilder jtmb)
+                          -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                          auto target_machine = jtmb.createTargetMachine();
+                          if (!target_machine) {
+                              return target_machine.takeError();
+                          }
+                          return std::make_unique<OptimizingCompiler>(std::move(*target_machine), opt_level, cache);
+                      })
+                      .create());
+
+    auto &dylib = _jit->getMainJITDylib();
+    // libc, for the memset/memcpy calls the backend may generate
+    dylib.addGenerator(unwrap(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        _jit->getDataLayout().getGlobalPrefix())));
+
+    // the sysy runtime is linked statically and not exported by l24, define it explicitly
+    llvm::orc::MangleAndInterner mangle(_jit->getExecutionSession(), _jit->getDataLayout());
+    llvm::orc::SymbolMap symbols;
+    unsigned count;
+    const RuntimeSymbol *runtime = getRuntimeSymbols(count);
+    for (unsigned i = 0; i < count; ++i) {
+        symbols[mangle(runtime[i]._name)] = {
+            llvm::orc::ExecutorAddr::fromPtr(runtime[i]._addr),
+            llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+    }
+
+    if (tiered) {
+        auto stubs_builder = llvm::orc::createLocalIndirectStubsManagerBuilder(_jit->getTargetTriple());
+        if (!stubs_builder) {
+            CodeGenContext::LogError("tiered execution is not supported on " +
+                                     _jit->getTargetTriple().str());
+        }
+        _stubs = stubs_builder();
+        symbols[mangle(TierUpCallbackName)] = {
+            llvm::orc::ExecutorAddr::fromPtr(&JIT::tierUpCallback),
+            llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+        // not a constant in the IR, which would make every module different per run
+        symbols[mangle(TierUpJITName)] = {
+            llvm::orc::ExecutorAddr::fromPtr(&_self), llvm::JITSymbolFlags::Exported};
+        // one background compiler, so the -O3 target machine is never shared
+        _tier_up_pool = std::make_unique<llvm::ThreadPool>(llvm::hardware_concurrency(1));
+    }
+    check(dylib.define(llvm::orc::absoluteSymbols(std::move(symbols))));
+}
+
+JIT::~JIT() {
+    if (_tier_up_pool) {
+        _tier_up_pool->wait();
+    }
+}
+
+void JIT::addModule(CodeGenBase &cgb) {
+    // optimized by OptimizingCompiler when LLJIT materializes it
+    auto tsm = cgb.takeModule(_target_machine.get());
+    if (_jit_opts._tier_up_threshold != 0) {
+        addTieredModule(std::move(tsm));
+        return;
+    }
+    check(_jit->addIRModule(std::move(tsm)));
+}
+
+unsigned JIT::cacheHits() const {
+    return (_object_cache ? _object_cache->hits() : 0) +
+           (_tier_up_object_cache ? _tier_up_object_cache->hits() : 0);
+}
+
+unsigned JIT::cacheMisses() const {
+    return (_object_cache ? _object_cache->misses() : 0) +
+           (_tier_up_object_cache ? _tier_up_object_cache->misses() : 0);
+}
+
+int64_t JIT::runMain() {
+    // the modules may call each other, so they are only compiled once all are added
+    for (unsigned id : _unbound) {
+        auto body = unwrap(_jit->lookup(_functions[id]._body_name));
+        check(_stubs->updatePointer(_functions[id]._name, body));
+    }
+    _unbound.clear();
+
+    auto main_addr = unwrap(_jit->lookup("main"));
+    auto *main_func = main_addr.toPtr<int64_t()>();
+    return main_func();
+}
+
+void JIT::addTieredModule(llvm::orc::ThreadSafeModule tsm) {
+    size_t module_id = _bitcodes.size();
+    std::vector<unsigned> ids;
+    tsm.withModuleDo([&](llvm::Module &module) {
+        // calls go through a declaration named like the function, which resolves to its
+        // stub, the body itself is renamed. main only runs once, it is never recompiled
+        std::vector<llvm::Function *> bodies;
+        for (auto &func : module) {
+            if (!func.isDeclaration() && func.getName() != "main") {
+                bodies.push_back(&func);
+            }
+        }
+        for (auto *body : bodies) {
+            std::string name = body->getName().str();
+            body->setName(name + ".tier0");
+            auto *decl = llvm::Function::Create(body->getFunctionType(),
+                                                llvm::Function::ExternalLinkage, name, module);
+            body->replaceAllUsesWith(decl);
+            ids.push_back(_functions.size());
+            _functions.push_back({name, body->getName().str(), module_id});
+        }
+
+        // the -O3 code refers to the globals of this module by name
+        for (auto &global : module.globals()) {
+            if (global.hasLocalLinkage()) {
+                global.setName("l24.m" + std::to_string(module_id) + "." + global.getName().str());
+                global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            }
+        }
+
+        llvm::raw_svector_ostream os(_bitcodes.emplace_back());
+        llvm::WriteBitcodeToFile(module, os);
+
+        for (unsigned id : ids) {
+            instrument(module, *module.getFunction(_functions[id]._body_name), id);
+        }
+    });
+
+    // every stub starts out pointing to nothing and is bound to the -O0 code by runMain
+    llvm::orc::MangleAndInterner mangle(_jit->getExecutionSession(), _jit->getDataLayout());
+    llvm::orc::SymbolMap stubs;
+    for (unsigned id : ids) {
+        const auto &name = _functions[id]._name;
+        check(_stubs->createStub(name, llvm::orc::ExecutorAddr(), llvm::JITSymbolFlags::Exported));
+        stubs[mangle(name)] = _stubs->findStub(name, false);
+    }
+    check(_jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(stubs))));
+
+    check(_jit->addIRModule(std::move(tsm)));
+    _unbound.insert(_unbound.end(), ids.begin(), ids.end());
+}
+
+void JIT::instrument(llvm::Module &module, llvm::Function &func, unsigned id) const {
+    auto &ctx = module.getContext();
+    auto *int64_ty = llvm::Type::getInt64Ty(ctx);
+    auto *counter = new llvm::GlobalVariable(module, int64_ty, false, llvm::GlobalValue::InternalLinkage,
+                                             llvm::ConstantInt::get(int64_ty, 0),
+                                             func.getName() + ".counter");
+    auto callback = module.getOrInsertFunction(
+        TierUpCallbackName, llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {int64_ty, int64_ty}, false));
+    auto *jit = module.getOrInsertGlobal(TierUpJITName, int64_ty);
+
+    // count at the function entry (after the allocas, which must stay in the entry
+    // block) and at every loop header
+    std::vector<llvm::Instruction *> points;
+    auto entry = func.getEntryBlock().begin();
+    while (llvm::isa<llvm::AllocaInst>(*entry)) {
+        ++entry;
+    }
+    points.push_back(&*entry);
+
+    llvm::SmallVector<std::pair<const llvm::BasicBlock *, const llvm::BasicBlock *>> back_edges;
+    llvm::FindFunctionBackedges(func, back_edges);
+    llvm::SmallPtrSet<const llvm::BasicBlock *, 8> headers;
+    for (const auto &edge : back_edges) {
+        if (headers.insert(edge.second).second) {
+            points.push_back(&*const_cast<llvm::BasicBlock *>(edge.second)->getFirstInsertionPt());
+        }
+    }
+
+    for (auto *point : points) {
+        llvm::IRBuilder<> builder(point);
+        auto *count = builder.CreateAdd(builder.CreateLoad(int64_ty, counter), llvm::ConstantInt::get(int64_ty, 1));
+        builder.CreateStore(count, counter);
+        auto *hot = builder.CreateICmpEQ(count, llvm::ConstantInt::get(int64_ty, _jit_opts._tier_up_threshold));
+        auto *then = llvm::SplitBlockAndInsertIfThen(hot, point, false);
+        llvm::IRBuilder<> then_builder(then);
+        then_builder.CreateCall(callback, {then_builder.CreateLoad(int64_ty, jit),
+                                           llvm::ConstantInt::get(int64_ty, id)});
+    }
+}
+
+void JIT::tierUp(unsigned id) {
+    const auto &func = _functions[id];
+    const auto &bitcode = _bitcodes[func._module];
+    llvm::LLVMContext ctx;
+    auto module = unwrap(llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), func._name), ctx));
+
+    // keep only the hot function, everything else is already defined by the -O0 module
+    for (auto &other : *module) {
+        if (!other.isDeclaration() && other.getName() != func._body_name) {
+            other.deleteBody();
+        }
+    }
+    for (auto &global : module->globals()) {
+        if (global.isDeclaration()) {
+            continue;
+        }
+        // constants keep their initializer for folding, nothing is emitted for them
+        if (global.isConstant()) {
+            global.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        } else {
+            global.setInitializer(nullptr);
+            global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+    module->getFunction(func._body_name)->setName(func._name + ".tier1");
+
+    check(_jit->addObjectFile(unwrap((*_tier_up_compiler)(*module))));
+
+    // from now on every new call runs the -O3 code
+    auto body = unwrap(_jit->lookup(func._name + ".tier1"));
+    check(_stubs->updatePointer(func._name, body));
+}
+
+void JIT::tierUpCallback(int64_t jit, int64_t id) {
+    auto *self = reinterpret_cast<JIT *>(jit);
+    self->_tier_up_pool->async([self, id] {
+        // the -O0 code keeps working if recompilation fails
+        try {
+            self->tierUp(static_cast<unsigned>(id));
+        } catch (const CodeGenError &err) {
+            llvm::errs() << "warning: recompiling " << self->_functions[id]._name
+                         << " failed: " << err.what() << "\n";
+        }
+    });
+}
+
+} // namespace l24
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include "backend/code_gen.h"
+#include "backend/code_gen_opts.h"
+#include "backend/jit_object_cache.h"
+
+namespace l24 {
+
+struct JITOptions {
+    // 0 compiles every module once at the opt level of the CodeGenOptions
+    uint64_t _tier_up_threshold = 0;
+    // persistent object cache, none if empty
+    std::string _cache_dir;
+};
+
+// Run l24 programs in process with ORC LLJIT.
+// Calls to the sysy runtime are bound to the copy linked into l24, so no assembler,
+// linker or child process is involved. Failures are reported by CodeGenError.
+//
+// With a tier-up threshold, modules are compiled at -O0 (fast startup) and every
+// function is called through an ORC indirect stub. Function entries and loop headers
+// count their executions, a function whose counter reaches the threshold is recompiled
+// at -O3 on a background thread and its stub is pointed to the new code. Calls that
+// are already running keep executing the -O0 code.
+//
+// With a cache directory, the objects of unchanged modules (and hot functions) are
+// loaded from disk, skipping both the optimization pipeline and codegen.
+class JIT {
+public:
+    explicit JIT(const CodeGenOptions &opts, const JITOptions &jit_opts = JITOptions());
+    ~JIT();
+
+    // optimize the module of cgb for the JIT target and take it over,
+    // modules of several translation units can be added to one JIT
+    void addModule(CodeGenBase &cgb);
+
+    // call main of the added modules, returns its return value
+    int64_t runMain();
+
+    unsigned cacheHits() const;
+    unsigned cacheMisses() const;
+
+private:
+    struct TieredFunction {
+        std::string _name;
+        // the -O0 body, the stub named _name points to it until the function is hot
+        std::string _body_name;
+        // bitcode of the module before instrumentation, the -O3 version is built from it
+        size_t _module;
+    };
+
+    void addTieredModule(llvm::orc::ThreadSafeModule tsm);
+    void instrument(llvm::Module &module, llvm::Function &func, unsigned id) const;
+    void tierUp(unsigned id);
+    // called by instrumented code, the first time a counter reaches the threshold
+    static void tierUpCallback(int64_t jit, int64_t id);
+
+    CodeGenOptions _opts;
+    JITOptions _jit_opts;
+    // only gives modules their triple and data layout, LLJIT owns its own target machines
+    std::unique_ptr<llvm::TargetMachine> _target_machine;
+    std::unique_ptr<JITObjectCache> _object_cache;
+    std::unique_ptr<llvm::orc::LLJIT> _jit;
+
+    // the address of this JIT, read by the tier-up calls of instrumented code
+    int64_t _self;
+    std::unique_ptr<JITObjectCache> _tier_up_object_cache;
+    std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler> _tier_up_compiler;
+    std::unique_ptr<llvm::orc::IndirectStubsManager> _stubs;
+    std::vector<llvm::SmallVector<char, 0>> _bitcodes;
+    std::vector<TieredFunction> _functions;
+    // functions whose stub isn't bound to the -O0 code yet
+    std::vector<unsigned> _unbound;
+    // declared last, so pending recompilations finish before the JIT is destroyed
+    std::unique_ptr<llvm::ThreadPool> _tier_up_pool;
+};
+
+} // namespace l24
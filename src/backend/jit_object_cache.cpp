@@ -0,0 +1,95 @@
+#include <chrono>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "backend/jit_object_cache.h"
+
+namespace l24 {
+
+std::string JITObjectCache::key(const llvm::Module &module) const {
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    llvm::BLAKE3 hasher;
+    hasher.update("l24-jit llvm-" LLVM_VERSION_STRING);
+    hasher.update(llvm::StringRef("\0", 1));
+    hasher.update(_config);
+    hasher.update(llvm::StringRef("\0", 1));
+    hasher.update(llvm::StringRef(bitcode.data(), bitcode.size()));
+    return llvm::toHex(hasher.final(), true);
+}
+
+std::string JITObjectCache::entryPath(const std::string &key) const {
+    llvm::SmallString<128> path(_dir);
+    llvm::sys::path::append(path, "llvmcache-" + key);
+    return std::string(path);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JITObjectCache::getObject(const llvm::Module *module) {
+    std::string module_key = key(*module);
+    std::string path = entryPath(module_key);
+    int fd;
+    if (!llvm::sys::fs::openFileForRead(path, fd)) {
+        // refresh the entry for LRU pruning
+        llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+        auto buffer = llvm::MemoryBuffer::getOpenFile(llvm::sys::fs::convertFDToNativeFile(fd),
+                                                      path, -1, false);
+        llvm::sys::fs::closeFile(fd);
+        if (buffer) {
+            ++_hits;
+            return std::move(*buffer);
+        }
+    }
+
+    ++_misses;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pending[module] = std::move(module_key);
+    return nullptr;
+}
+
+void JITObjectCache::notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef object) {
+    std::string module_key;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _pending.find(module);
+        if (it == _pending.end()) {
+            return;
+        }
+        module_key = std::move(it->second);
+        _pending.erase(it);
+    }
+
+    // a cache that can't be written is not an error, the object is just not cached
+    if (llvm::sys::fs::create_directories(_dir)) {
+        return;
+    }
+    llvm::SmallString<128> model(_dir);
+    llvm::sys::path::append(model, "tmp-%%%%%%%%");
+    int fd;
+    llvm::SmallString<128> tmp_path;
+    if (llvm::sys::fs::createUniqueFile(model, fd, tmp_path)) {
+        return;
+    }
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        os << object.getBuffer();
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    if (llvm::sys::fs::rename(tmp_path, entryPath(module_key))) {
+        llvm::sys::fs::remove(tmp_path);
+    }
+}
+
+} // namespace l24
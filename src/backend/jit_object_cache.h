@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace l24 {
+
+// Persistent llvm::ObjectCache for JIT compiled modules.
+// The key is the hash of the module bitcode (before optimization, the JIT compiler looks
+// the module up before running the pipeline) and of the target machine configuration:
+// llvm version, triple, cpu, features and opt level. Objects are stored as
+// <dir>/llvmcache-<hash>, the same layout as the driver's compilation cache, so both can
+// share a directory and its LRU pruning.
+class JITObjectCache : public llvm::ObjectCache {
+public:
+    JITObjectCache(std::string dir, std::string config): _dir(std::move(dir)), _config(std::move(config)) {}
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *module) override;
+    void notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef object) override;
+
+    unsigned hits() const { return _hits; }
+    unsigned misses() const { return _misses; }
+
+private:
+    std::string key(const llvm::Module &module) const;
+    std::string entryPath(const std::string &key) const;
+
+    std::string _dir;
+    std::string _config;
+    // keys computed by getObject, the module is optimized before it is compiled
+    std::mutex _mutex;
+    std::map<const llvm::Module *, std::string> _pending;
+    std::atomic<unsigned> _hits{0};
+    std::atomic<unsigned> _misses{0};
+};
+
+} // namespace l24
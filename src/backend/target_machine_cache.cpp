@@ -0,0 +1,36 @@
+#include "backend/code_gen.h"
+#include "backend/target_machine_cache.h"
+
+namespace l24 {
+
+std::string TargetMachineCache::key(const CodeGenOptions &opts) {
+    // the triple is always the default one
+    return opts._cpu + " " + opts._features + " O" + std::to_string(opts._opt_level);
+}
+
+std::unique_ptr<llvm::TargetMachine> TargetMachineCache::acquire(const CodeGenOptions &opts) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto &idle = _idle[key(opts)];
+        if (!idle.empty()) {
+            auto target_machine = std::move(idle.back());
+            idle.pop_back();
+            return target_machine;
+        }
+        ++_created;
+    }
+    return CodeGenBase::createTargetMachine(opts);
+}
+
+void TargetMachineCache::release(const CodeGenOptions &opts,
+                                 std::unique_ptr<llvm::TargetMachine> target_machine) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _idle[key(opts)].push_back(std::move(target_machine));
+}
+
+unsigned TargetMachineCache::created() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _created;
+}
+
+} // namespace l24
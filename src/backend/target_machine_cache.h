@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/Target/TargetMachine.h"
+
+#include "backend/code_gen_opts.h"
+
+namespace l24 {
+
+// TargetMachines keyed by (triple, cpu, features, opt level), reused across modules.
+// Creating one looks up the target, parses the feature string and builds the subtarget,
+// which is a noticeable part of compiling a small file.
+// A TargetMachine must only be used by one thread at a time: acquire() hands out an idle
+// one (or creates it) and release() puts it back.
+class TargetMachineCache {
+public:
+    std::unique_ptr<llvm::TargetMachine> acquire(const CodeGenOptions &opts);
+    void release(const CodeGenOptions &opts, std::unique_ptr<llvm::TargetMachine> target_machine);
+
+    // number of TargetMachines created so far
+    unsigned created() const;
+
+private:
+    static std::string key(const CodeGenOptions &opts);
+
+    mutable std::mutex _mutex;
+    std::map<std::string, std::vector<std::unique_ptr<llvm::TargetMachine>>> _idle;
+    unsigned _created = 0;
+};
+
+} // namespace l24
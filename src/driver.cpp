@@ -10,37 +10,464 @@
 //  Created by Mike Lischke on 13.03.16.
 //
 
-#include "antlr4-runtime.h"
+#include <chrono>
+#include <cstdlib>
 
-#include "llvm/Support/Debug.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/TargetParser/Host.h"
 
-#include "frontend/ast.h"
-#include "frontend/front_end.h"
-#include "backend/code_gen.h"
+#include "backend/code_gen_opts.h"
+#include "backend/jit.h"
+#include "backend/target_machine_cache.h"
+#include "driver/batch_manifest.h"
+#include "driver/compilation.h"
+#include "driver/compile_cache.h"
+#include "driver/compile_server.h"
+#include "driver/linker.h"
+#include "frontend/front_end_opts.h"
 
-using namespace antlr4;
 using namespace l24;
 
+static llvm::cl::list<std::string> InputFilenames(llvm::cl::Positional,
+                                                  llvm::cl::desc("<filenames>"),
+                                                  llvm::cl::ZeroOrMore);
+
+static llvm::cl::opt<unsigned> Jobs("j",
+                                    llvm::cl::desc("Number of files compiled in parallel (default = one per hardware thread)"),
+                                    llvm::cl::value_desc("N"), llvm::cl::Prefix, llvm::cl::init(0));
+
+static llvm::cl::opt<char> OptLevel("O",
+                                    llvm::cl::desc("Optimization level. [-O0, -O1, -O2, or -O3] (default = '-O0')"),
+                                    llvm::cl::Prefix, llvm::cl::init('0'));
+
+static llvm::cl::opt<std::string> OutputFilename("o",
+                                                 llvm::cl::desc("Write output to <file>"),
+                                                 llvm::cl::value_desc("file"));
+
+static llvm::cl::opt<bool> EmitAssembly("S", llvm::cl::desc("Only run compile steps, emit assembly"));
+
+static llvm::cl::opt<bool> CompileOnly("c", llvm::cl::desc("Only run compile and assemble steps, emit an object file"));
+
+static llvm::cl::opt<bool> EmitLLVM("emit-llvm", llvm::cl::desc("Emit (optimized) textual LLVM IR, bitcode together with -c"));
+
+static llvm::cl::opt<bool> EmitBC("emit-bc", llvm::cl::desc("Emit (optimized) LLVM bitcode"));
+
+static llvm::cl::opt<bool> DumpTokens("dump-tokens", llvm::cl::desc("Print the token stream to stdout"));
+
+static llvm::cl::opt<bool> DumpParseTree("dump-parse-tree", llvm::cl::desc("Print the ANTLR parse tree to stdout"));
+
+static llvm::cl::opt<bool> ParseStats("parse-stats", llvm::cl::desc("Print ATN/DFA prediction statistics of the parser to stdout"));
+
+static llvm::cl::opt<bool> DumpAST("dump-ast", llvm::cl::desc("Write the binary AST of every input to <output>.ast (<input>.ast when linking or running)"));
+
+static llvm::cl::opt<bool> LoadAST("load-ast", llvm::cl::desc("Read the inputs as binary ASTs written by --dump-ast instead of parsing sources"));
+
+static llvm::cl::opt<LexerKind> Lexer("lexer",
+                                      llvm::cl::desc("Lexer that tokenizes the sources (default = antlr)"),
+                                      llvm::cl::values(clEnumValN(LexerKind::ANTLR, "antlr", "Lexer generated by ANTLR"),
+                                                       clEnumValN(LexerKind::Native, "native", "Hand-written lexer, same tokens")),
+                                      llvm::cl::init(LexerKind::ANTLR));
+
+static llvm::cl::opt<ParserKind> Parser("parser",
+                                        llvm::cl::desc("Parser that builds the AST (default = antlr)"),
+                                        llvm::cl::values(clEnumValN(ParserKind::ANTLR, "antlr", "Parser generated by ANTLR and a walk of its parse tree"),
+                                                         clEnumValN(ParserKind::Native, "native", "Hand-written recursive-descent parser, same AST")),
+                                        llvm::cl::init(ParserKind::ANTLR));
+
+static llvm::cl::opt<unsigned> ParseThreads("parse-threads",
+                                            llvm::cl::desc("Number of threads that parse the top-level items of a large file (0 = one per hardware thread, default = 1)"),
+                                            llvm::cl::value_desc("N"), llvm::cl::init(1));
+
+static llvm::cl::opt<std::string> BatchManifest("batch",
+                                                llvm::cl::desc("Compile the '<input> <output> [flags]' lines of <manifest> in one process and print a timing summary"),
+                                                llvm::cl::value_desc("manifest"));
+
+static llvm::cl::opt<bool> Run("run", llvm::cl::desc("JIT compile the inputs and run main in process, exit with its return value"));
+
+static llvm::cl::opt<uint64_t> TierUpThreshold("tier-up-threshold",
+                                               llvm::cl::desc("With --run, compile at -O0 first and recompile a function at -O3 in the background after <N> calls and loop iterations (default = 0, disabled)"),
+                                               llvm::cl::value_desc("N"), llvm::cl::init(0));
+
+static llvm::cl::opt<std::string> CacheDir("cache-dir",
+                                           llvm::cl::desc("Reuse outputs of identical compilations stored in <dir> (default = $L24_CACHE_DIR, no cache if unset)"),
+                                           llvm::cl::value_desc("dir"));
+
+static llvm::cl::opt<uint64_t> CacheSize("cache-size",
+                                         llvm::cl::desc("Evict least recently used cache entries above <MB> megabytes (default = 512)"),
+                                         llvm::cl::value_desc("MB"), llvm::cl::init(512));
+
+static llvm::cl::opt<bool> CacheStats("cache-stats", llvm::cl::desc("Print cache hits and misses to stderr"));
+
+static llvm::cl::opt<bool> DumpIR("dump-ir", llvm::cl::desc("Print the IR before optimization to stdout"));
+
+static llvm::cl::list<std::string> LibraryDirs("L",
+                                               llvm::cl::desc("Add directory to library search path"),
+                                               llvm::cl::value_desc("dir"), llvm::cl::Prefix);
+
+static llvm::cl::opt<std::string> MArch("march",
+                                        llvm::cl::desc("Target cpu, 'native' selects the host cpu and its features"),
+                                        llvm::cl::value_desc("cpu-name"));
+
+static llvm::cl::opt<std::string> MCPU("mcpu",
+                                       llvm::cl::desc("Target a specific cpu type (-mcpu=help for details)"),
+                                       llvm::cl::value_desc("cpu-name"));
+
+static llvm::cl::opt<std::string> MAttrs("mattr",
+                                         llvm::cl::desc("Target specific attributes, eg: +avx2,-avx512f"),
+                                         llvm::cl::value_desc("a1,+a2,-a3,..."));
+
+static llvm::cl::opt<std::string> ServeSocket("serve",
+                                              llvm::cl::desc("Run as a compile server listening on the unix domain socket <path>"),
+                                              llvm::cl::value_desc("path"));
+
+static llvm::cl::opt<std::string> ConnectSocket("connect",
+                                                llvm::cl::desc("Submit compilations to the compile server listening on <path>"),
+                                                llvm::cl::value_desc("path"));
+
+static llvm::cl::opt<bool> TimeTrace("ftime-trace",
+                                     llvm::cl::desc("Write a Chrome trace (JSON) of every compile phase and function"));
+
+static llvm::cl::opt<unsigned> TimeTraceGranularity("ftime-trace-granularity",
+                                                    llvm::cl::desc("Minimum time granularity (in microseconds) traced by -ftime-trace"),
+                                                    llvm::cl::init(500));
+
+static llvm::cl::opt<std::string> TimeTraceFile("ftime-trace-file",
+                                                llvm::cl::desc("Trace output file of -ftime-trace (default = <output>.time-trace, the first output if there are several)"),
+                                                llvm::cl::value_desc("file"));
+
+static llvm::cl::opt<bool> TimeReport("ftime-report",
+                                      llvm::cl::desc("Print a summary of the time spent in every compile phase and pass"));
+
+// fill cpu/features of opts from -march/-mcpu/-mattr, -mcpu wins over -march
+static void setTargetOptions(CodeGenOptions &opts) {
+    std::string cpu = !MCPU.empty() ? MCPU : MArch;
+    // JIT compiled code only ever runs on this machine
+    if (cpu.empty() && Run) {
+        cpu = "native";
+    }
+    std::vector<std::string> features;
+    if (cpu == "native") {
+        cpu = std::string(llvm::sys::getHostCPUName());
+        std::string host_features = CodeGenBase::getHostFeatures();
+        if (!host_features.empty()) {
+            features.push_back(host_features);
+        }
+    }
+    if (!MAttrs.empty()) {
+        features.push_back(MAttrs);
+    }
+
+    if (!cpu.empty()) {
+        opts._cpu = cpu;
+    }
+    opts._features = llvm::join(features, ",");
+}
+
+// without any of -S/-c/-emit-llvm/-emit-bc the objects are linked into an executable
+static bool linkRequested() {
+    return !EmitAssembly && !CompileOnly && !EmitLLVM && !EmitBC;
+}
+
+// -S -emit-llvm and -c -emit-llvm behave like clang
+static EmitKind getEmitKind() {
+    if (EmitBC || (EmitLLVM && CompileOnly)) {
+        return EmitKind::Bitcode;
+    }
+    if (EmitLLVM) {
+        return EmitKind::LLVMIR;
+    }
+    return EmitAssembly ? EmitKind::Assembly : EmitKind::Object;
+}
+
+// default output: <stem>.s/.o/.ll/.bc, a.out for an executable
+static std::string getOutputFilename(const std::string &input) {
+    if (!OutputFilename.empty()) {
+        return OutputFilename;
+    }
+    if (linkRequested()) {
+        return "a.out";
+    }
+
+    const char *ext;
+    switch (getEmitKind()) {
+    case EmitKind::Assembly: ext = "s"; break;
+    case EmitKind::Object: ext = "o"; break;
+    case EmitKind::LLVMIR: ext = "ll"; break;
+    case EmitKind::Bitcode: ext = "bc"; break;
+    }
+    llvm::SmallString<128> path(llvm::sys::path::filename(input));
+    llvm::sys::path::replace_extension(path, ext);
+    return std::string(path);
+}
+
+// <output>.ast next to the output of input, or <input>.ast in the current directory when
+// the output is a temporary object or there is none
+static std::string getASTFilename(const std::string &input, const std::string &output) {
+    llvm::SmallString<128> path(output.empty() ? llvm::sys::path::filename(input) : llvm::StringRef(output));
+    llvm::sys::path::replace_extension(path, "ast");
+    return std::string(path);
+}
+
+// --cache-dir, or $L24_CACHE_DIR
+static std::string getCacheDir() {
+    if (!CacheDir.empty()) {
+        return CacheDir;
+    }
+    const char *env = std::getenv("L24_CACHE_DIR");
+    return env != nullptr ? env : "";
+}
+
+// compile every input into one JIT and call main, no object file or executable is written
+static int runJIT(const CodeGenOptions &opts, const FrontEndOptions &front_end_opts,
+                  const DumpOptions &dumps) {
+    JITOptions jit_opts;
+    jit_opts._tier_up_threshold = TierUpThreshold;
+    jit_opts._cache_dir = getCacheDir();
+    std::unique_ptr<JIT> jit;
+    try {
+        jit = std::make_unique<JIT>(opts, jit_opts);
+    } catch (const CodeGenError &err) {
+        llvm::errs() << "error: " << err.what() << "\n";
+        return 1;
+    }
+
+    bool ok = true;
+    for (const auto &input : InputFilenames) {
+        if (llvm::sys::path::extension(input) == ".o") {
+            llvm::errs() << "error: " << input << ": object files can't be run, pass the sources\n";
+            return 1;
+        }
+        CompileJob job(input, "", EmitKind::Object, opts);
+        job.setFrontEndOptions(front_end_opts);
+        job.setDumps(dumps);
+        job.setInputIsAST(LoadAST);
+        if (DumpAST) {
+            job.setASTOutput(getASTFilename(input, ""));
+        }
+        ok = job.addToJIT(*jit) && ok;
+        llvm::outs() << job.dump();
+        llvm::errs() << job.diagnostics();
+    }
+    if (!ok) {
+        return 1;
+    }
+
+    // the program writes through stdio, don't let our buffered dumps overtake it
+    llvm::outs().flush();
+    int ret;
+    try {
+        ret = static_cast<int>(jit->runMain());
+    } catch (const CodeGenError &err) {
+        llvm::errs() << "error: " << err.what() << "\n";
+        return 1;
+    }
+
+    if (!jit_opts._cache_dir.empty()) {
+        CompileCache(jit_opts._cache_dir, "").prune(CacheSize * 1024 * 1024);
+        if (CacheStats) {
+            llvm::errs() << "l24 jit cache: " << jit->cacheHits() << " hits, " << jit->cacheMisses()
+                         << " misses\n";
+        }
+    }
+    return ret;
+}
+
+static void printBatchSummary(const std::vector<CompileJob> &jobs, double seconds,
+                              unsigned target_machines) {
+    llvm::errs() << "===== Batch Summary =====\n";
+    unsigned succeeded = 0;
+    for (const auto &job : jobs) {
+        llvm::errs() << llvm::format("%10.3f ms  ", job.seconds() * 1000)
+                     << (job.succeeded() ? "ok     " : "failed ") << job.input() << "\n";
+        succeeded += job.succeeded();
+    }
+    llvm::errs() << jobs.size() << " files (" << succeeded << " ok) in "
+                 << llvm::format("%.3f s, %.1f files/s, ", seconds, jobs.size() / seconds)
+                 << target_machines << " target machines\n";
+}
+
 int main(int argc, const char *argv[]) {
-    if (argc != 2) {
-        llvm::errs() << "Usage: ./bin/l24 <filename>" << "\n";
+    llvm::cl::ParseCommandLineOptions(argc, argv, "l24 compiler\n");
+
+    CodeGenOptions opts;
+    if (OptLevel < '0' || OptLevel > '3') {
+        llvm::errs() << "error: invalid optimization level: -O" << OptLevel << "\n";
         return 1;
     }
+    opts._opt_level = OptLevel - '0';
+    setTargetOptions(opts);
 
-    std::string filename(argv[1]);
-    std::ifstream stream(filename);
-    if (!stream.good()) {
-      llvm::errs() << "error: no such file: '" << filename << "'\n";
-      return 1;
+    if (!ServeSocket.empty()) {
+        return CompileServer(ServeSocket).serve(Jobs);
+    }
+    bool batch = !BatchManifest.empty();
+    if (InputFilenames.empty() && !batch) {
+        llvm::errs() << "error: no input files\n";
+        return 1;
     }
 
-    FrontEnd front_end;
-    auto entry_node = front_end.parse(stream);
+    FrontEndOptions front_end_opts;
+    front_end_opts._lexer = Lexer;
+    front_end_opts._parser = Parser;
+    front_end_opts._parse_threads = ParseThreads;
+    DumpOptions dumps;
+    dumps._tokens = DumpTokens;
+    dumps._parse_tree = DumpParseTree;
+    dumps._parse_stats = ParseStats;
+    dumps._ir = DumpIR;
+    if (Run) {
+        return runJIT(opts, front_end_opts, dumps);
+    }
 
-    CodeGenBase cgb;
-    cgb.codeGenEntry(entry_node);
-    cgb.asmGen();
+    bool link = !batch && linkRequested();
+    if (!link && !OutputFilename.empty() && InputFilenames.size() > 1) {
+        llvm::errs() << "error: cannot specify -o when generating multiple output files\n";
+        return 1;
+    }
+
+    // one job per source file, executables are linked from temporary objects.
+    // objects compiled earlier with -c are passed to the linker as they are,
+    // so only the changed translation units need to be rebuilt
+    auto kind = link ? EmitKind::Object : getEmitKind();
+    std::string cache_dir = getCacheDir();
+    std::unique_ptr<CompileCache> cache;
+    if (!cache_dir.empty()) {
+        cache = std::make_unique<CompileCache>(cache_dir, CompileCache::compilerId(argv[0]));
+    }
+
+    // TargetMachines are reused by all jobs with the same options
+    TargetMachineCache target_machines;
+    std::vector<CompileJob> jobs;
+    auto add_job = [&](const std::string &input, const std::string &output, EmitKind job_kind,
+                       const CodeGenOptions &job_opts) {
+        jobs.emplace_back(input, output, job_kind, job_opts);
+        jobs.back().setFrontEndOptions(front_end_opts);
+        jobs.back().setDumps(dumps);
+        jobs.back().setInputIsAST(LoadAST);
+        if (DumpAST) {
+            jobs.back().setASTOutput(getASTFilename(input, link ? "" : output));
+        }
+        jobs.back().setCache(cache.get());
+        jobs.back().setTargetMachines(&target_machines);
+        if (!ConnectSocket.empty()) {
+            jobs.back().setServer(ConnectSocket);
+        }
+    };
+
+    if (batch) {
+        std::vector<BatchEntry> entries;
+        std::string err;
+        if (!readBatchManifest(BatchManifest, opts, kind, entries, err)) {
+            llvm::errs() << "error: " << err << "\n";
+            return 1;
+        }
+        for (const auto &entry : entries) {
+            add_job(entry._input, entry._output, entry._kind, entry._opts);
+        }
+    }
+
+    std::vector<std::string> objects;
+    std::vector<std::unique_ptr<llvm::FileRemover>> obj_removers;
+    for (const auto &input : InputFilenames) {
+        if (llvm::sys::path::extension(input) == ".o") {
+            if (link) {
+                objects.push_back(input);
+            } else {
+                llvm::errs() << "warning: " << input << ": linker input unused\n";
+            }
+            continue;
+        }
+
+        std::string output;
+        if (link) {
+            llvm::SmallString<128> obj_path;
+            if (auto EC = llvm::sys::fs::createTemporaryFile("l24", "o", obj_path)) {
+                llvm::errs() << "error: unable to create temporary file: " << EC.message() << "\n";
+                return 1;
+            }
+            obj_removers.push_back(std::make_unique<llvm::FileRemover>(obj_path));
+            output = std::string(obj_path);
+            objects.push_back(output);
+        } else {
+            output = getOutputFilename(input);
+        }
+        add_job(input, output, kind, opts);
+    }
+
+    // llvm timers can't be shared by concurrent jobs, time them one after another
+    unsigned jobs_num = Jobs;
+    if (TimeReport) {
+        llvm::TimePassesIsEnabled = true;
+        jobs_num = 1;
+    }
+    if (TimeTrace) {
+        llvm::timeTraceProfilerInitialize(TimeTraceGranularity, argv[0]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        llvm::ThreadPool pool(llvm::hardware_concurrency(jobs_num));
+        for (auto &job : jobs) {
+            pool.async([&job] {
+                // the profiler is per thread, every job gets its own instance
+                if (TimeTrace) {
+                    llvm::timeTraceProfilerInitialize(TimeTraceGranularity, "l24");
+                }
+                job.run();
+                if (TimeTrace) {
+                    llvm::timeTraceProfilerFinishThread();
+                }
+            });
+        }
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (TimeTrace) {
+        // the executable, or the output of the first source when there are several
+        std::string fallback = link ? getOutputFilename("") : !jobs.empty() ? jobs.front().output() : "l24";
+        if (auto err = llvm::timeTraceProfilerWrite(TimeTraceFile, fallback)) {
+            llvm::errs() << "error: " << llvm::toString(std::move(err)) << "\n";
+        }
+        llvm::timeTraceProfilerCleanup();
+    }
+    if (TimeReport) {
+        llvm::TimerGroup::printAll(llvm::errs());
+    }
+
+    if (cache) {
+        cache->prune(CacheSize * 1024 * 1024);
+        if (CacheStats) {
+            llvm::errs() << "l24 cache: " << cache->hits() << " hits, " << cache->misses()
+                         << " misses\n";
+        }
+    }
+
+    // report diagnostics in input order, whichever worker finished first
+    bool ok = true;
+    for (const auto &job : jobs) {
+        llvm::outs() << job.dump();
+        llvm::errs() << job.diagnostics();
+        ok = ok && job.succeeded();
+    }
+    if (batch) {
+        printBatchSummary(jobs, seconds, target_machines.created());
+    }
+    if (!ok) {
+        return 1;
+    }
+    if (!link) {
+        return 0;
+    }
 
-    return 0;
+    return Linker::link(objects, LibraryDirs, getOutputFilename("")) ? 0 : 1;
 }
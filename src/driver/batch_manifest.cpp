@@ -0,0 +1,89 @@
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/TargetParser/Host.h"
+
+#include "backend/code_gen.h"
+#include "driver/batch_manifest.h"
+
+namespace l24 {
+
+bool readBatchManifest(const std::string &path, const CodeGenOptions &defaults, EmitKind default_kind,
+                       std::vector<BatchEntry> &entries, std::string &err) {
+    auto buffer = llvm::MemoryBuffer::getFile(path, true);
+    if (!buffer) {
+        err = path + ": " + buffer.getError().message();
+        return false;
+    }
+
+    llvm::SmallVector<llvm::StringRef> lines;
+    (*buffer)->getBuffer().split(lines, '\n');
+    for (size_t i = 0; i < lines.size(); ++i) {
+        auto error = [&](const std::string &message) {
+            err = path + ":" + std::to_string(i + 1) + ": " + message;
+            return false;
+        };
+
+        llvm::StringRef line = lines[i].trim();
+        if (line.empty() || line.starts_with("#")) {
+            continue;
+        }
+        llvm::SmallVector<llvm::StringRef> tokens;
+        llvm::SplitString(line, tokens);
+        if (tokens.size() < 2) {
+            return error("expected '<input> <output> [flags]'");
+        }
+
+        BatchEntry entry;
+        entry._input = tokens[0].str();
+        entry._output = tokens[1].str();
+        entry._kind = default_kind;
+        entry._opts = defaults;
+        bool assembly = false, object = false, llvm_ir = false, bitcode = false;
+        for (size_t j = 2; j < tokens.size(); ++j) {
+            llvm::StringRef flag = tokens[j];
+            if (flag.consume_front("-O")) {
+                if (flag.size() != 1 || flag[0] < '0' || flag[0] > '3') {
+                    return error("invalid optimization level: -O" + flag.str());
+                }
+                entry._opts._opt_level = flag[0] - '0';
+            } else if (flag == "-S") {
+                assembly = true;
+            } else if (flag == "-c") {
+                object = true;
+            } else if (flag == "-emit-llvm") {
+                llvm_ir = true;
+            } else if (flag == "-emit-bc") {
+                bitcode = true;
+            } else if (flag.consume_front("-mcpu=")) {
+                entry._opts._cpu = flag.str();
+                entry._opts._features.clear();
+                if (flag == "native") {
+                    entry._opts._cpu = llvm::sys::getHostCPUName().str();
+                    entry._opts._features = CodeGenBase::getHostFeatures();
+                }
+            } else if (flag.consume_front("-mattr=")) {
+                entry._opts._features = entry._opts._features.empty()
+                                            ? flag.str()
+                                            : entry._opts._features + "," + flag.str();
+            } else {
+                return error("unknown flag '" + flag.str() + "'");
+            }
+        }
+
+        // the same rules as the command line, -c -emit-llvm writes bitcode
+        if (bitcode || (llvm_ir && object)) {
+            entry._kind = EmitKind::Bitcode;
+        } else if (llvm_ir) {
+            entry._kind = EmitKind::LLVMIR;
+        } else if (assembly) {
+            entry._kind = EmitKind::Assembly;
+        } else if (object) {
+            entry._kind = EmitKind::Object;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+} // namespace l24
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "backend/code_gen_opts.h"
+
+namespace l24 {
+
+struct BatchEntry {
+    std::string _input;
+    std::string _output;
+    EmitKind _kind;
+    CodeGenOptions _opts;
+};
+
+// Read a batch manifest, one compilation per line:
+//     <input> <output> [-O<n>] [-S|-c|-emit-llvm|-emit-bc] [-mcpu=<cpu>] [-mattr=<features>]
+// Entries start from the command line options and their flags override them.
+// Empty lines and lines starting with '#' are skipped.
+// Returns false with err set to "<path>:<line>: <message>" on a malformed line.
+bool readBatchManifest(const std::string &path, const CodeGenOptions &defaults, EmitKind default_kind,
+                       std::vector<BatchEntry> &entries, std::string &err);
+
+} // namespace l24
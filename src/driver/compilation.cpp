@@ -0,0 +1,226 @@
+#include <chrono>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "frontend/ast_serializer.h"
+#include "frontend/front_end.h"
+#include "backend/code_gen.h"
+#include "backend/jit.h"
+#include "backend/target_machine_cache.h"
+#include "driver/compilation.h"
+#include "driver/compile_cache.h"
+#include "driver/compile_server.h"
+#include "support/phase_timer.h"
+
+namespace l24 {
+
+CompileJob::CompileJob(std::string input, std::string output, EmitKind kind,
+                       const CodeGenOptions &opts):
+    _input(std::move(input)), _output(std::move(output)), _kind(kind), _opts(opts) {}
+
+bool CompileJob::run() {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runImpl();
+    _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+bool CompileJob::runImpl() {
+    _diagnostics.clear();
+    _dump.clear();
+    _succeeded = false;
+    _cache_hit = false;
+
+    auto source = loadSource();
+    if (source == nullptr) {
+        return false;
+    }
+
+    bool use_cache = _cache != nullptr && !_dumps._tokens && !_dumps._parse_tree &&
+                     !_dumps._parse_stats && !_dumps._ir && _ast_output.empty();
+    std::string key;
+    std::string output;
+    if (use_cache) {
+        key = _cache->key(source->getBuffer(), _kind, _opts);
+        _cache_hit = _cache->lookup(key, output);
+    }
+
+    if (!_cache_hit) {
+        bool ok;
+        // AST files are read and written by this process, the server only gets sources
+        if (!_server_socket.empty() && !_input_is_ast && _ast_output.empty()) {
+            ok = runOnServer(source->getBuffer(), output);
+        } else {
+            llvm::SmallString<0> buffer;
+            llvm::raw_svector_ostream dest(buffer);
+            ok = compile(source->getMemBufferRef(), dest);
+            output = std::string(buffer.str());
+        }
+        if (!ok) {
+            return false;
+        }
+        if (use_cache) {
+            _cache->store(key, output);
+        }
+    }
+
+    // the output is complete before the file is opened, so a failed compile never
+    // leaves a truncated output behind
+    std::error_code EC;
+    bool is_text = _kind == EmitKind::Assembly || _kind == EmitKind::LLVMIR;
+    auto flags = is_text ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None;
+    llvm::raw_fd_ostream dest(_output, EC, flags);
+    if (EC) {
+        _diagnostics += "error: could not open file: " + _output + ": " + EC.message() + "\n";
+        return false;
+    }
+    dest << output;
+
+    _succeeded = true;
+    return true;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CompileJob::loadSource() {
+    // the file is mapped instead of read when it is large enough, and neither the
+    // cache nor the lexer copies it. no null terminator is needed, so a file of exactly
+    // a page multiple is mapped as well
+    PhaseTimer timer("load", "Source Loading");
+    auto buffer = llvm::MemoryBuffer::getFile(_input, false, false);
+    if (!buffer) {
+        _diagnostics = "error: no such file: '" + _input + "'\n";
+        return nullptr;
+    }
+    return std::move(*buffer);
+}
+
+std::unique_ptr<CodeGenBase> CompileJob::generate(llvm::MemoryBufferRef source) {
+    llvm::raw_string_ostream dump_os(_dump);
+    FrontEnd front_end(_front_end_opts);
+    front_end.enableDumps(dump_os, _dumps._tokens, _dumps._parse_tree, _dumps._parse_stats);
+    // the AST only lives until the IR is generated
+    ASTArena arena;
+    EntryNode *entry_node;
+    if (_input_is_ast) {
+        PhaseTimer timer("load-ast", "AST Loading");
+        std::string err;
+        entry_node = readAST(source, arena, err);
+        if (entry_node == nullptr) {
+            _diagnostics = _input + ": error: invalid AST file: " + err + "\n";
+            return nullptr;
+        }
+    } else {
+        entry_node = front_end.parse(source, arena);
+        if (entry_node == nullptr) {
+            for (const auto &err : front_end.errors()) {
+                _diagnostics += _input + ":" + err + "\n";
+            }
+            return nullptr;
+        }
+    }
+    if (!_ast_output.empty() && !writeASTFile(*entry_node)) {
+        return nullptr;
+    }
+
+    try {
+        auto cgb = std::make_unique<CodeGenBase>(_opts);
+        cgb->codeGenEntry(entry_node);
+        if (_dumps._ir) {
+            cgb->printModule(dump_os);
+        }
+        return cgb;
+    } catch (const CodeGenError &err) {
+        _diagnostics = _input + ": Error: " + err.what() + "\n";
+        return nullptr;
+    }
+}
+
+bool CompileJob::writeASTFile(const EntryNode &entry) {
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(_ast_output, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        _diagnostics = "error: could not open file: " + _ast_output + ": " + EC.message() + "\n";
+        return false;
+    }
+    writeAST(entry, dest);
+    return true;
+}
+
+bool CompileJob::compile(llvm::MemoryBufferRef source, llvm::raw_pwrite_stream &dest) {
+    llvm::TimeTraceScope trace("Compile", _input);
+    _diagnostics.clear();
+    _dump.clear();
+    _succeeded = false;
+
+    auto cgb = generate(source);
+    if (cgb == nullptr) {
+        return false;
+    }
+    std::unique_ptr<llvm::TargetMachine> target_machine;
+    try {
+        if (_target_machines != nullptr) {
+            target_machine = _target_machines->acquire(_opts);
+        }
+        cgb->emit(dest, _kind, target_machine.get());
+    } catch (const CodeGenError &err) {
+        _diagnostics = _input + ": Error: " + err.what() + "\n";
+        return false;
+    }
+    if (target_machine != nullptr) {
+        _target_machines->release(_opts, std::move(target_machine));
+    }
+
+    _succeeded = true;
+    return true;
+}
+
+bool CompileJob::addToJIT(JIT &jit) {
+    llvm::TimeTraceScope trace("Compile", _input);
+    _diagnostics.clear();
+    _dump.clear();
+    _succeeded = false;
+
+    auto source = loadSource();
+    if (source == nullptr) {
+        return false;
+    }
+    auto cgb = generate(source->getMemBufferRef());
+    if (cgb == nullptr) {
+        return false;
+    }
+    try {
+        jit.addModule(*cgb);
+    } catch (const CodeGenError &err) {
+        _diagnostics = _input + ": Error: " + err.what() + "\n";
+        return false;
+    }
+
+    _succeeded = true;
+    return true;
+}
+
+bool CompileJob::runOnServer(llvm::StringRef source, std::string &output) {
+    CompileRequest request;
+    request._kind = _kind;
+    request._opts = _opts;
+    request._front_end_opts = _front_end_opts;
+    request._dumps = _dumps;
+    request._input = _input;
+    request._source = source.str();
+
+    CompileResponse response;
+    std::string err;
+    if (!CompileClient::request(_server_socket, request, response, err)) {
+        _diagnostics = "error: compile server " + _server_socket + ": " + err + "\n";
+        return false;
+    }
+
+    _diagnostics = std::move(response._diagnostics);
+    _dump = std::move(response._dump);
+    output = std::move(response._output);
+    return response._succeeded;
+}
+
+} // namespace l24
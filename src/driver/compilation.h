@@ -0,0 +1,109 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "backend/code_gen_opts.h"
+#include "frontend/front_end_opts.h"
+
+namespace l24 {
+
+class CodeGenBase;
+class CompileCache;
+class EntryNode;
+class JIT;
+class TargetMachineCache;
+
+// debug dumps, printed to stdout in input order. all off by default, so the normal
+// compile path doesn't serialize anything but its output
+struct DumpOptions {
+    bool _tokens = false;
+    bool _parse_tree = false;
+    // ATN/DFA prediction statistics of the parser
+    bool _parse_stats = false;
+    // IR before optimization
+    bool _ir = false;
+};
+
+// Compile one l24 source file into one output file.
+// Every job owns its FrontEnd and CodeGenBase (LLVMContext, Module, IRBuilder), so
+// jobs can run on different threads at the same time.
+class CompileJob {
+public:
+    CompileJob(std::string input, std::string output, EmitKind kind, const CodeGenOptions &opts);
+
+    // parse, generate code and emit the output file.
+    // diagnostics are buffered, so the driver can print them in input order
+    bool run();
+
+    // compile source into dest, shared by run() and the compile server
+    bool compile(llvm::MemoryBufferRef source, llvm::raw_pwrite_stream &dest);
+
+    // parse and generate code, then hand the module to jit instead of emitting it.
+    // the output file and kind are unused
+    bool addToJIT(JIT &jit);
+
+    // submit the job to a compile server listening on socket_path instead of
+    // compiling it in this process
+    void setServer(std::string socket_path) { _server_socket = std::move(socket_path); }
+
+    void setDumps(const DumpOptions &dumps) { _dumps = dumps; }
+
+    void setFrontEndOptions(const FrontEndOptions &front_end_opts) { _front_end_opts = front_end_opts; }
+
+    // the input is a binary AST written by --dump-ast instead of a source file
+    void setInputIsAST(bool input_is_ast) { _input_is_ast = input_is_ast; }
+
+    // write the binary AST of the input to path, see frontend/ast_serializer.h.
+    // the job always parses, a cached output has no AST
+    void setASTOutput(std::string path) { _ast_output = std::move(path); }
+
+    // reuse outputs of earlier compilations of the same source and options.
+    // jobs with dumps enabled always compile, a cached output has nothing to dump
+    void setCache(CompileCache *cache) { _cache = cache; }
+
+    // take TargetMachines from a cache shared by many jobs instead of creating one per job
+    void setTargetMachines(TargetMachineCache *target_machines) { _target_machines = target_machines; }
+
+    const std::string &input() const { return _input; }
+    const std::string &output() const { return _output; }
+    const std::string &diagnostics() const { return _diagnostics; }
+    // output of the enabled DumpOptions
+    const std::string &dump() const { return _dump; }
+    bool succeeded() const { return _succeeded; }
+    bool cacheHit() const { return _cache_hit; }
+    // wall time of the last run()
+    double seconds() const { return _seconds; }
+
+private:
+    bool runImpl();
+    std::unique_ptr<llvm::MemoryBuffer> loadSource();
+    // parse and generate IR, nullptr on errors
+    std::unique_ptr<CodeGenBase> generate(llvm::MemoryBufferRef source);
+    bool runOnServer(llvm::StringRef source, std::string &output);
+    bool writeASTFile(const EntryNode &entry);
+
+    std::string _input;
+    std::string _output;
+    EmitKind _kind;
+    CodeGenOptions _opts;
+    FrontEndOptions _front_end_opts;
+    bool _input_is_ast = false;
+    std::string _ast_output;
+    DumpOptions _dumps;
+    std::string _diagnostics;
+    std::string _dump;
+    bool _succeeded = false;
+    std::string _server_socket;
+    CompileCache *_cache = nullptr;
+    bool _cache_hit = false;
+    TargetMachineCache *_target_machines = nullptr;
+    double _seconds = 0;
+};
+
+} // namespace l24
@@ -0,0 +1,109 @@
+#include <chrono>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/BLAKE3.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Host.h"
+
+#include "driver/compile_cache.h"
+
+namespace l24 {
+
+std::string CompileCache::compilerId(const char *argv0) {
+    std::string id = "l24 llvm-" LLVM_VERSION_STRING;
+    std::string exe = llvm::sys::fs::getMainExecutable(argv0, (void *) &CompileCache::compilerId);
+    llvm::sys::fs::file_status status;
+    if (!exe.empty() && !llvm::sys::fs::status(exe, status)) {
+        auto mtime = status.getLastModificationTime().time_since_epoch();
+        id += " " + std::to_string(status.getSize()) + " " + std::to_string(mtime.count());
+    }
+    return id;
+}
+
+std::string CompileCache::key(llvm::StringRef source, EmitKind kind,
+                              const CodeGenOptions &opts) const {
+    llvm::BLAKE3 hasher;
+    // every field is terminated, so that moving bytes between fields changes the hash
+    auto add = [&hasher](llvm::StringRef field) {
+        hasher.update(field);
+        hasher.update(llvm::StringRef("\0", 1));
+    };
+    add(_compiler_id);
+    add(llvm::sys::getDefaultTargetTriple());
+    add(opts._cpu);
+    add(opts._features);
+    add(std::to_string(opts._opt_level));
+    add(std::to_string(static_cast<int>(kind)));
+    add(source);
+    return llvm::toHex(hasher.final(), true);
+}
+
+std::string CompileCache::entryPath(const std::string &key) const {
+    llvm::SmallString<128> path(_dir);
+    llvm::sys::path::append(path, "llvmcache-" + key);
+    return std::string(path);
+}
+
+bool CompileCache::lookup(const std::string &key, std::string &output) {
+    std::string path = entryPath(key);
+    int fd;
+    if (llvm::sys::fs::openFileForRead(path, fd)) {
+        ++_misses;
+        return false;
+    }
+    // refresh the entry for LRU eviction, atime alone is unreliable on noatime mounts
+    llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+    auto buffer = llvm::MemoryBuffer::getOpenFile(llvm::sys::fs::convertFDToNativeFile(fd),
+                                                  path, -1, false);
+    llvm::sys::fs::closeFile(fd);
+    if (!buffer) {
+        ++_misses;
+        return false;
+    }
+    output = (*buffer)->getBuffer().str();
+    ++_hits;
+    return true;
+}
+
+void CompileCache::store(const std::string &key, const std::string &output) {
+    // a cache that can't be written is not an error, the output is just not cached
+    if (llvm::sys::fs::create_directories(_dir)) {
+        return;
+    }
+    llvm::SmallString<128> model(_dir);
+    llvm::sys::path::append(model, "tmp-%%%%%%%%");
+    int fd;
+    llvm::SmallString<128> tmp_path;
+    if (llvm::sys::fs::createUniqueFile(model, fd, tmp_path)) {
+        return;
+    }
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        os << output;
+        os.close();
+        if (os.has_error()) {
+            os.clear_error();
+            llvm::sys::fs::remove(tmp_path);
+            return;
+        }
+    }
+    if (llvm::sys::fs::rename(tmp_path, entryPath(key))) {
+        llvm::sys::fs::remove(tmp_path);
+    }
+}
+
+bool CompileCache::prune(uint64_t max_bytes) const {
+    llvm::CachePruningPolicy policy;
+    // always scan, l24 runs are short and there is no background pruning
+    policy.Interval = std::chrono::seconds(0);
+    policy.MaxSizePercentageOfAvailableSpace = 0;
+    policy.MaxSizeBytes = max_bytes;
+    return llvm::pruneCache(_dir, policy);
+}
+
+} // namespace l24
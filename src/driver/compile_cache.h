@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "backend/code_gen_opts.h"
+
+namespace l24 {
+
+// On-disk cache of compiler outputs, addressed by the hash of everything that can
+// change them: source bytes, compiler build, target triple/cpu/features, opt level and
+// output kind. A hit is copied to the output without running FrontEnd or CodeGenBase.
+// Entries are stored as <dir>/llvmcache-<hash>, so llvm::pruneCache can evict them in
+// LRU order, lookups refresh the access time of an entry.
+class CompileCache {
+public:
+    CompileCache(std::string dir, std::string compiler_id):
+        _dir(std::move(dir)), _compiler_id(std::move(compiler_id)) {}
+
+    // identifies the running compiler binary: llvm version plus size and mtime of the
+    // executable, so a rebuilt l24 never reuses outputs of the old one
+    static std::string compilerId(const char *argv0);
+
+    std::string key(llvm::StringRef source, EmitKind kind, const CodeGenOptions &opts) const;
+
+    bool lookup(const std::string &key, std::string &output);
+    // stores are atomic (written to a temporary file and renamed), so concurrent jobs
+    // and concurrent l24 processes can share one directory
+    void store(const std::string &key, const std::string &output);
+
+    // evict least recently used entries until the directory is below max_bytes
+    bool prune(uint64_t max_bytes) const;
+
+    unsigned hits() const { return _hits; }
+    unsigned misses() const { return _misses; }
+
+private:
+    std::string entryPath(const std::string &key) const;
+
+    std::string _dir;
+    std::string _compiler_id;
+    std::atomic<unsigned> _hits{0};
+    std::atomic<unsigned> _misses{0};
+};
+
+} // namespace l24
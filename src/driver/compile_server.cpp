@@ -0,0 +1,288 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "backend/code_gen.h"
+#include "driver/compilation.h"
+#include "driver/compile_server.h"
+
+namespace l24 {
+
+// bump it whenever the layout of a request/response changes
+static constexpr uint32_t ProtocolVersion = 6;
+
+// longest string field of a request/response, a longer one is rejected before anything
+// is allocated for it
+static constexpr uint64_t MaxStringSize = 256 * 1024 * 1024;
+
+namespace {
+// closes the socket on every path out of a scope, so a client is never left waiting
+class ScopedFD {
+public:
+    explicit ScopedFD(int fd): _fd(fd) {}
+    ScopedFD(const ScopedFD &) = delete;
+    ScopedFD &operator=(const ScopedFD &) = delete;
+    ~ScopedFD() { ::close(_fd); }
+
+    int get() const { return _fd; }
+
+private:
+    int _fd;
+};
+} // namespace
+
+static bool writeAll(int fd, const void *buf, size_t len) {
+    auto ptr = static_cast<const char *>(buf);
+    while (len > 0) {
+        ssize_t n = ::write(fd, ptr, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void *buf, size_t len) {
+    auto ptr = static_cast<char *>(buf);
+    while (len > 0) {
+        ssize_t n = ::read(fd, ptr, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        ptr += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool writeInt(int fd, uint64_t val) {
+    return writeAll(fd, &val, sizeof(val));
+}
+
+static bool readInt(int fd, uint64_t &val) {
+    return readAll(fd, &val, sizeof(val));
+}
+
+// strings are sent as <length><bytes>
+static bool writeString(int fd, const std::string &str) {
+    return writeInt(fd, str.size()) && writeAll(fd, str.data(), str.size());
+}
+
+static bool readString(int fd, std::string &str) {
+    uint64_t size;
+    if (!readInt(fd, size) || size > MaxStringSize) {
+        return false;
+    }
+    str.resize(size);
+    return readAll(fd, str.data(), size);
+}
+
+static bool writeRequest(int fd, const CompileRequest &request) {
+    return writeInt(fd, ProtocolVersion) &&
+           writeInt(fd, static_cast<uint64_t>(request._kind)) &&
+           writeInt(fd, request._opts._opt_level) &&
+           writeInt(fd, static_cast<uint64_t>(request._front_end_opts._lexer)) &&
+           writeInt(fd, static_cast<uint64_t>(request._front_end_opts._parser)) &&
+           writeInt(fd, request._front_end_opts._parse_threads) &&
+           writeInt(fd, request._dumps._tokens) &&
+           writeInt(fd, request._dumps._parse_tree) &&
+           writeInt(fd, request._dumps._parse_stats) &&
+           writeInt(fd, request._dumps._ir) &&
+           writeString(fd, request._opts._cpu) &&
+           writeString(fd, request._opts._features) &&
+           writeString(fd, request._input) &&
+           writeString(fd, request._source);
+}
+
+static bool readRequest(int fd, CompileRequest &request) {
+    uint64_t version, kind, opt_level, lexer, parser, parse_threads, tokens, parse_tree, parse_stats, ir;
+    if (!readInt(fd, version) || version != ProtocolVersion) {
+        return false;
+    }
+    if (!readInt(fd, kind) || !readInt(fd, opt_level) ||
+        !readInt(fd, lexer) || !readInt(fd, parser) || !readInt(fd, parse_threads) ||
+        !readInt(fd, tokens) || !readInt(fd, parse_tree) ||
+        !readInt(fd, parse_stats) || !readInt(fd, ir)) {
+        return false;
+    }
+    // the enums are only cast once they are known to be in range
+    if (kind > static_cast<uint64_t>(EmitKind::Bitcode) || opt_level > 3 ||
+        lexer > static_cast<uint64_t>(LexerKind::Native) ||
+        parser > static_cast<uint64_t>(ParserKind::Native) ||
+        parse_threads > UINT32_MAX) {
+        return false;
+    }
+    request._kind = static_cast<EmitKind>(kind);
+    request._opts._opt_level = opt_level;
+    request._front_end_opts._lexer = static_cast<LexerKind>(lexer);
+    request._front_end_opts._parser = static_cast<ParserKind>(parser);
+    request._front_end_opts._parse_threads = parse_threads;
+    request._dumps._tokens = tokens != 0;
+    request._dumps._parse_tree = parse_tree != 0;
+    request._dumps._parse_stats = parse_stats != 0;
+    request._dumps._ir = ir != 0;
+    return readString(fd, request._opts._cpu) &&
+           readString(fd, request._opts._features) &&
+           readString(fd, request._input) &&
+           readString(fd, request._source);
+}
+
+static bool writeResponse(int fd, const CompileResponse &response) {
+    return writeInt(fd, response._succeeded) &&
+           writeString(fd, response._diagnostics) &&
+           writeString(fd, response._dump) &&
+           writeString(fd, response._output);
+}
+
+static bool readResponse(int fd, CompileResponse &response) {
+    uint64_t succeeded;
+    if (!readInt(fd, succeeded)) {
+        return false;
+    }
+    response._succeeded = succeeded != 0;
+    return readString(fd, response._diagnostics) &&
+           readString(fd, response._dump) &&
+           readString(fd, response._output);
+}
+
+static bool getSocketAddress(const std::string &socket_path, sockaddr_un &addr, std::string &err) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        err = "socket path is too long";
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+void CompileServer::warmUp() const {
+    // deserialize the ATN and fill the DFA of the most common decisions once
+    CompileJob job("<warm-up>", "", EmitKind::Object, CodeGenOptions());
+    llvm::StringRef source("int g = 1;\nint main() { int a[2] = {1, 2}; "
+                           "if (a[0] < g) then { return 1; } end while (0) {} return 0; }\n");
+    llvm::SmallString<0> buffer;
+    llvm::raw_svector_ostream dest(buffer);
+    job.compile(llvm::MemoryBufferRef(source, "<warm-up>"), dest);
+}
+
+void CompileServer::handle(int fd) const {
+    CompileRequest request;
+    CompileResponse response;
+    // an exception must not escape into the thread pool, that would terminate the
+    // server together with every other compilation in flight
+    try {
+        if (!readRequest(fd, request)) {
+            return;
+        }
+        CompileJob job(request._input, "", request._kind, request._opts);
+        job.setFrontEndOptions(request._front_end_opts);
+        job.setDumps(request._dumps);
+        llvm::SmallString<0> buffer;
+        llvm::raw_svector_ostream dest(buffer);
+
+        response._succeeded = job.compile(llvm::MemoryBufferRef(request._source, request._input), dest);
+        response._diagnostics = job.diagnostics();
+        response._dump = job.dump();
+        response._output = std::string(buffer.str());
+    } catch (const std::exception &err) {
+        response = CompileResponse();
+        response._diagnostics = request._input + ": error: " + err.what() + "\n";
+    }
+    writeResponse(fd, response);
+}
+
+int CompileServer::serve(unsigned jobs) {
+    sockaddr_un addr;
+    std::string err;
+    if (!getSocketAddress(_socket_path, addr, err)) {
+        llvm::errs() << "error: " << _socket_path << ": " << err << "\n";
+        return 1;
+    }
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        llvm::errs() << "error: socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    // a stale socket of a killed server would make bind fail
+    ::unlink(_socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, SOMAXCONN) < 0) {
+        llvm::errs() << "error: " << _socket_path << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd);
+        return 1;
+    }
+    llvm::sys::RemoveFileOnSignal(_socket_path);
+    // a client going away must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    CodeGenBase::initTargets();
+    warmUp();
+
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+    while (true) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            llvm::errs() << "error: accept: " << std::strerror(errno) << "\n";
+            break;
+        }
+        pool.async([this, fd] {
+            ScopedFD client(fd);
+            handle(client.get());
+        });
+    }
+
+    pool.wait();
+    ::close(listen_fd);
+    return 1;
+}
+
+bool CompileClient::request(const std::string &socket_path, const CompileRequest &request,
+                            CompileResponse &response, std::string &err) {
+    sockaddr_un addr;
+    if (!getSocketAddress(socket_path, addr, err)) {
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        err = std::strerror(errno);
+        return false;
+    }
+    ScopedFD server(fd);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        err = std::strerror(errno);
+        return false;
+    }
+
+    bool ok = writeRequest(fd, request) && readResponse(fd, response);
+    if (!ok) {
+        err = "connection closed by the server";
+    }
+    return ok;
+}
+
+} // namespace l24
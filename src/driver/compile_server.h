@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+#include "backend/code_gen_opts.h"
+#include "driver/compilation.h"
+
+namespace l24 {
+
+struct CompileRequest {
+    EmitKind _kind = EmitKind::Object;
+    CodeGenOptions _opts;
+    FrontEndOptions _front_end_opts;
+    DumpOptions _dumps;
+    // file name, only used in diagnostics
+    std::string _input;
+    std::string _source;
+};
+
+struct CompileResponse {
+    bool _succeeded = false;
+    std::string _diagnostics;
+    std::string _dump;
+    // IR, bitcode, assembly or object code
+    std::string _output;
+};
+
+// A long running compiler listening on a unix domain socket.
+// Targets are initialized and the ANTLR ATN/DFA caches (static data of the generated
+// lexer/parser) are filled once, so a request only pays for its own compilation.
+class CompileServer {
+public:
+    explicit CompileServer(std::string socket_path): _socket_path(std::move(socket_path)) {}
+
+    // serve requests until the process is killed, returns non-zero on setup failure
+    int serve(unsigned jobs);
+
+private:
+    void warmUp() const;
+    void handle(int fd) const;
+
+    std::string _socket_path;
+};
+
+class CompileClient {
+public:
+    // send one request to the server at socket_path and wait for its response
+    static bool request(const std::string &socket_path, const CompileRequest &request,
+                        CompileResponse &response, std::string &err);
+};
+
+} // namespace l24
@@ -0,0 +1,51 @@
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "driver/linker.h"
+
+namespace l24 {
+
+static std::string findLinkerDriver() {
+    for (const char *name : {"cc", "clang", "gcc"}) {
+        if (auto path = llvm::sys::findProgramByName(name)) {
+            return *path;
+        }
+    }
+    return "";
+}
+
+bool Linker::link(const std::vector<std::string> &objects,
+                  const std::vector<std::string> &lib_dirs, const std::string &output) {
+    std::string program = findLinkerDriver();
+    if (program.empty()) {
+        llvm::errs() << "error: unable to find a linker driver (cc/clang/gcc) in PATH\n";
+        return false;
+    }
+
+    std::vector<std::string> lib_flags;
+    for (const auto &dir : lib_dirs) {
+        lib_flags.push_back("-L" + dir);
+    }
+    lib_flags.push_back(std::string("-L") + L24_RUNTIME_DIR);
+
+    // static library must come after the objects that reference it
+    std::vector<llvm::StringRef> args = {program};
+    args.insert(args.end(), objects.begin(), objects.end());
+    args.insert(args.end(), lib_flags.begin(), lib_flags.end());
+    args.insert(args.end(), {"-lsysy", "-o", output});
+
+    std::string err_msg;
+    int ret = llvm::sys::ExecuteAndWait(program, args, std::nullopt, {}, 0, 0, &err_msg);
+    if (ret != 0) {
+        llvm::errs() << "error: linker command failed";
+        if (!err_msg.empty()) {
+            llvm::errs() << ": " << err_msg;
+        }
+        llvm::errs() << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace l24
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace l24 {
+
+class Linker {
+public:
+    // Link object files with the sysy runtime into an executable.
+    // The system C compiler driver is invoked, so crt files and libc are found the same
+    // way as `gcc -L../../lib -lsysy output.S` used to.
+    static bool link(const std::vector<std::string> &objects,
+                     const std::vector<std::string> &lib_dirs, const std::string &output);
+};
+
+} // namespace l24
@@ -1,16 +1,20 @@
 #pragma once
 
-#include <utility>
-#include <vector>
+#include <cstdint>
 #include <iostream>
-#include <memory>
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Value.h"
 
+#include "frontend/symbol_table.h"
+
 namespace l24 {
 class CodeGenContext;
 
 
+// Nodes are allocated in an ASTArena and never destroyed one by one, so they only hold
+// raw pointers to other nodes and StringRef/ArrayRef into the arena.
 class ASTNode {
 public:
     virtual ~ASTNode() = default; 
@@ -18,94 +22,104 @@ public:
 
 class EntryNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> _prog;
+    // ProgNode
+    ASTNode *_prog = nullptr;
+    // names of the Symbols in this AST
+    const SymbolTable *_symbols = nullptr;
 };
 
 class ProgNode : public ASTNode  {
 public:
-    std::shared_ptr<ASTNode> _decl;
-    std::shared_ptr<ASTNode> _func;
-    std::shared_ptr<ASTNode> _prog;
+    // ItemNodes in source order
+    llvm::ArrayRef<ASTNode *> _items;
 };
 
-class FuncNode : public ASTNode {
+class ItemNode : public ASTNode {
 public:
-    std::string _type;
-    std::string _ident;
-    std::shared_ptr<ASTNode> _block;
-    std::shared_ptr<ASTNode> _param;
+    ASTNode *_decl = nullptr;
+    ASTNode *_func = nullptr;
+    ASTNode *_extern_decl = nullptr;
 };
 
-class FuncFParamsNode : public ASTNode {
+class ExternDeclNode : public ASTNode {
 public:
-    std::vector<std::shared_ptr<ASTNode>> _params;
+    bool _is_func{false};
+    bool _is_array{false};
+    llvm::StringRef _type;
+    Symbol _ident = NoSymbol;
+    // function: FuncFParamsNode
+    ASTNode *_param = nullptr;
+    // array: size of the array, may be empty
+    ASTNode *_exp = nullptr;
 };
 
-class FuncFParamNode : public ASTNode {
+class FuncNode : public ASTNode {
 public:
-    std::string _type;
-    std::string _ident;
+    llvm::StringRef _type;
+    Symbol _ident = NoSymbol;
+    ASTNode *_block = nullptr;
+    ASTNode *_param = nullptr;
 };
 
-class FuncRParamsNode : public ASTNode {
+class FuncFParamsNode : public ASTNode {
 public:
-    std::vector<std::shared_ptr<ASTNode>> _exps;
+    llvm::ArrayRef<ASTNode *> _params;
+};
+
+class FuncFParamNode : public ASTNode {
+public:
+    llvm::StringRef _type;
+    Symbol _ident = NoSymbol;
 };
 
 class BlockNode : public ASTNode {
 public:
-    std::vector<std::shared_ptr<ASTNode>> _block_items;
+    llvm::ArrayRef<ASTNode *> _block_items;
 };
 
 class BlockItemNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> _decl;
-    std::shared_ptr<ASTNode> _stmt;
+    ASTNode *_decl = nullptr;
+    ASTNode *_stmt = nullptr;
 };
 
 class DeclNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> _const_decl;
-    std::shared_ptr<ASTNode> _var_decl;
+    ASTNode *_const_decl = nullptr;
+    ASTNode *_var_decl = nullptr;
 };
 
 class ConstDeclNode : public ASTNode {
 public:
-    std::string _b_type;
-    std::vector<std::shared_ptr<ASTNode>> _const_defs;
+    llvm::StringRef _b_type;
+    llvm::ArrayRef<ASTNode *> _const_defs;
 };
 
 class VarDeclNode : public ASTNode {
 public:
-    std::string _b_type;
-    std::vector<std::shared_ptr<ASTNode>> _var_defs;
+    llvm::StringRef _b_type;
+    llvm::ArrayRef<ASTNode *> _var_defs;
 };
 
 class ConstDefNode : public ASTNode {
 public:
-    std::string _ident;
-    std::shared_ptr<ASTNode> _init_val;
-    std::shared_ptr<ASTNode> _exp;
+    Symbol _ident = NoSymbol;
+    ASTNode *_init_val = nullptr;
+    ASTNode *_exp = nullptr;
 };
 
 class VarDefNode : public ASTNode {
 public:
-    std::string _ident;
-    std::shared_ptr<ASTNode> _init_val;
-    std::shared_ptr<ASTNode> _exp;
+    Symbol _ident = NoSymbol;
+    ASTNode *_init_val = nullptr;
+    ASTNode *_exp = nullptr;
 };
 
 class InitValNode : public ASTNode {
 public:
     bool _is_array;
-    std::string _string_literal;
-    std::vector<std::shared_ptr<ASTNode>> _exp;
-};
-
-class LValNode : public ASTNode {
-public:
-    std::string _ident;
-    std::shared_ptr<ASTNode> _exp;
+    llvm::StringRef _string_literal;
+    llvm::ArrayRef<ASTNode *> _exp;
 };
 
 class StmtNode : public ASTNode {
@@ -113,89 +127,67 @@ public:
     bool _is_ret_stmt;
     bool _is_continue_stmt;
     bool _is_break_stmt;
-    std::string _l_val;
-    std::shared_ptr<ASTNode> _sub_idx;
-    std::shared_ptr<ASTNode> _expr;
-    std::shared_ptr<ASTNode> _block;
-    std::shared_ptr<ASTNode> _if_stmt;
-    std::shared_ptr<ASTNode> _else_stmt;
-    std::shared_ptr<ASTNode> _while_stmt;
-};
-
+    // assignment target, NoSymbol if this isn't an assignment
+    Symbol _l_val = NoSymbol;
+    ASTNode *_sub_idx = nullptr;
+    ASTNode *_expr = nullptr;
+    ASTNode *_block = nullptr;
+    ASTNode *_if_stmt = nullptr;
+    ASTNode *_else_stmt = nullptr;
+    ASTNode *_while_stmt = nullptr;
+};
+
+// Expressions are lowered from the precedence levels of the grammar (lOrExp -> ... ->
+// primaryExp) to one node per operator or operand, a literal is a single LiteralNode.
+// _kind lets codegen dispatch without dynamic casts.
 class ExprNode : public ASTNode {
 public:
-    std::shared_ptr<ASTNode> _lor_expr;
-};
-
-class LorExprNode : public ASTNode {
-public:
-    std::shared_ptr<ASTNode> _land_expr;
-    std::shared_ptr<ASTNode> _lor_expr;
-};
-
-class LandExprNode : public ASTNode {
-public:
-    std::shared_ptr<ASTNode> _eq_expr;
-    std::shared_ptr<ASTNode> _land_expr;
+    enum class Kind { Binary, Unary, Literal, VarRef, Call };
+    const Kind _kind;
+    explicit ExprNode(Kind kind): _kind(kind) {}
 };
 
+enum class BinaryOp { Or, And, Eq, Ne, Lt, Gt, Le, Ge, Add, Sub, Mul, Div, Rem };
 
-class EqExprNode : public ASTNode {
-public:
-    std::string op;
-    std::shared_ptr<ASTNode> _rel_expr;
-    std::shared_ptr<ASTNode> _eq_expr;
-};
+// unary plus is dropped by the builder
+enum class UnaryOp { Neg, Not };
 
-class RelExprNode : public ASTNode {
+class BinaryExprNode : public ExprNode {
 public:
-    std::string op;
-    std::shared_ptr<ASTNode> _add_expr;
-    std::shared_ptr<ASTNode> _rel_expr;
+    BinaryOp _op;
+    ExprNode *_lhs = nullptr;
+    ExprNode *_rhs = nullptr;
+    BinaryExprNode(BinaryOp op, ExprNode *lhs, ExprNode *rhs):
+        ExprNode(Kind::Binary), _op(op), _lhs(lhs), _rhs(rhs) {}
 };
 
-class AddExprNode : public ASTNode {
+class UnaryExprNode : public ExprNode {
 public:
-    char _op{'\0'};
-    std::shared_ptr<ASTNode> _mul_expr;
-    std::shared_ptr<ASTNode> _add_expr;
+    UnaryOp _op;
+    ExprNode *_operand = nullptr;
+    UnaryExprNode(UnaryOp op, ExprNode *operand):
+        ExprNode(Kind::Unary), _op(op), _operand(operand) {}
 };
 
-class MulExprNode : public ASTNode {
+class LiteralNode : public ExprNode {
 public:
-    char _op{'\0'};
-    std::shared_ptr<ASTNode> _unary_expr;
-    std::shared_ptr<ASTNode> _mul_expr;
+    int64_t _int_literal;
+    explicit LiteralNode(int64_t literal): ExprNode(Kind::Literal), _int_literal(literal) {}
 };
 
-class UnaryExprNode : public ASTNode {
+// a variable/const, or an element of an array if _exp is set
+class VarRefNode : public ExprNode {
 public:
-    std::shared_ptr<ASTNode> _primary_expr;
-    std::shared_ptr<ASTNode> _unary_op;
-    std::shared_ptr<ASTNode> _unary_expr;
-    std::string _func_ident;
-    std::shared_ptr<ASTNode> _func_r_params;
+    Symbol _ident = NoSymbol;
+    ExprNode *_exp = nullptr;
+    VarRefNode(): ExprNode(Kind::VarRef) {}
 };
 
-class UnaryOpNode : public ASTNode {
+class CallNode : public ExprNode {
 public:
-    std::string _op;
-    explicit UnaryOpNode(std::string op): _op(std::move(op)){}
+    Symbol _func_ident = NoSymbol;
+    llvm::ArrayRef<ExprNode *> _args;
+    CallNode(): ExprNode(Kind::Call) {}
 };
 
-class PrimExprNode : public ASTNode {
-public:
-    std::shared_ptr<ASTNode> _expr;
-    std::shared_ptr<ASTNode> _number;
-    std::shared_ptr<ASTNode> _l_val;
-};
-
-class NumberNode : public ASTNode {
-public:
-    long long _int_literal;
-    explicit NumberNode(int literal): _int_literal(literal) {}
-};
-
-
-    
 } // namespace l24
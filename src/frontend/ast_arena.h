@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+#include "frontend/symbol_table.h"
+
+namespace l24 {
+
+// Bump-pointer arena that owns every node of one AST.
+// Nodes point to each other with raw pointers and are never destroyed one by one, the
+// whole tree is freed at once with the slabs of the arena. So nodes must not own heap
+// memory: strings and lists are copied into the arena as StringRef/ArrayRef, identifiers
+// are interned in the SymbolTable of the arena.
+//
+// The chunks of a source parsed in parallel each get a child arena, which allocates on
+// its own thread but interns into the SymbolTable of its parent, and is adopted by the
+// parent once the chunk is parsed.
+class ASTArena {
+public:
+    ASTArena() = default;
+    explicit ASTArena(ASTArena &parent): _parent(&parent) {}
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        ++_nodes;
+        return new (_allocator.Allocate<T>()) T(std::forward<Args>(args)...);
+    }
+
+    llvm::StringRef copyString(llvm::StringRef str) {
+        if (str.empty()) {
+            return {};
+        }
+        char *data = _allocator.Allocate<char>(str.size());
+        std::memcpy(data, str.data(), str.size());
+        return {data, str.size()};
+    }
+
+    // list is usually a std::vector that is filled while building a node
+    template <typename List>
+    llvm::ArrayRef<typename List::value_type> copyList(const List &list) {
+        using T = typename List::value_type;
+        if (list.empty()) {
+            return {};
+        }
+        T *data = _allocator.Allocate<T>(list.size());
+        std::uninitialized_copy(list.begin(), list.end(), data);
+        return {data, list.size()};
+    }
+
+    Symbol intern(llvm::StringRef name) {
+        if (_parent == nullptr) {
+            return _symbols.intern(name);
+        }
+        // the shared table is only locked for the first use of a name in this chunk
+        auto [it, inserted] = _interned.try_emplace(name, NoSymbol);
+        if (inserted) {
+            std::lock_guard<std::mutex> lock(_parent->_symbols_mutex);
+            it->second = _parent->_symbols.intern(name);
+        }
+        return it->second;
+    }
+    const SymbolTable &symbols() const { return _parent != nullptr ? _parent->symbols() : _symbols; }
+
+    // keep the nodes of child alive as long as the nodes of this arena
+    void adopt(std::unique_ptr<ASTArena> child) { _children.push_back(std::move(child)); }
+
+    // number of nodes, and of bytes/slabs (the only heap allocations) for all of them
+    size_t nodes() const {
+        size_t nodes = _nodes;
+        for (const auto &child : _children) {
+            nodes += child->nodes();
+        }
+        return nodes;
+    }
+    size_t bytes() const {
+        size_t bytes = _allocator.getBytesAllocated();
+        for (const auto &child : _children) {
+            bytes += child->bytes();
+        }
+        return bytes;
+    }
+    size_t slabs() const {
+        size_t slabs = _allocator.GetNumSlabs();
+        for (const auto &child : _children) {
+            slabs += child->slabs();
+        }
+        return slabs;
+    }
+
+private:
+    llvm::BumpPtrAllocator _allocator;
+    SymbolTable _symbols;
+    size_t _nodes = 0;
+
+    // chunk arenas only
+    ASTArena *_parent = nullptr;
+    // the Symbols of the names used in this chunk
+    llvm::StringMap<Symbol> _interned;
+
+    // parent arenas only
+    std::mutex _symbols_mutex;
+    std::vector<std::unique_ptr<ASTArena>> _children;
+};
+
+} // namespace l24
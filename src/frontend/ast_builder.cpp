@@ -1,68 +1,97 @@
-#include <any>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "frontend/ast_builder.h"
 #include "frontend/ast.h"
 
 namespace l24 {
 
-std::shared_ptr<ASTNode> ASTBuilder::build(l24Parser::EntryContext *ctx) {
-    return std::any_cast<std::shared_ptr<EntryNode>>(visitEntry(ctx));
+EntryNode *ASTBuilder::buildEntry(ASTArena &arena, ProgNode *program) {
+    auto entry = arena.create<EntryNode>();
+    entry->_prog = program;
+    entry->_symbols = &arena.symbols();
+    return entry;
 }
 
-
-std::any ASTBuilder::visitEntry(l24Parser::EntryContext *ctx) {
-    auto entry = std::make_shared<EntryNode>();
-    entry->_prog = std::move(std::any_cast<std::shared_ptr<ProgNode>>(visitProgram(ctx->program())));
-    return entry;
+ProgNode *ASTBuilder::buildProgram(ASTArena &arena, llvm::ArrayRef<ASTNode *> items) {
+    auto program = arena.create<ProgNode>();
+    program->_items = arena.copyList(items);
+    return program;
 }
 
-std::any ASTBuilder::visitProgram(l24Parser::ProgramContext *ctx) {
-    auto program = std::make_shared<ProgNode>();
+ItemNode *ASTBuilder::buildItem(l24Parser::ItemContext *ctx) {
+    auto item = _arena.create<ItemNode>();
     if (ctx->func()) {
-        program->_func = std::move(std::any_cast<std::shared_ptr<FuncNode>>(visitFunc(ctx->func())));
+        item->_func = buildFunc(ctx->func());
     }
     if (ctx->decl()) {
-        program->_decl = std::move(std::any_cast<std::shared_ptr<DeclNode>>(visitDecl(ctx->decl())));
+        item->_decl = buildDecl(ctx->decl());
     }
-    if (ctx->program()) {
-        program->_prog = std::move(std::any_cast<std::shared_ptr<ProgNode>>(visitProgram(ctx->program())));
+    if (ctx->externDecl()) {
+        item->_extern_decl = buildExternDecl(ctx->externDecl());
     }
-    return program;
+    return item;
 }
 
-std::any ASTBuilder::visitFunc(l24Parser::FuncContext *ctx) {
-    auto func = std::make_shared<FuncNode>();
+FuncNode *ASTBuilder::buildFunc(l24Parser::FuncContext *ctx) {
+    auto func = _arena.create<FuncNode>();
     if (ctx->Int() != nullptr) {
-        func->_type = ctx->Int()->getText();
+        func->_type = _arena.copyString(ctx->Int()->getText());
     } else {
-        func->_type = ctx->Void()->getText();
+        func->_type = _arena.copyString(ctx->Void()->getText());
     }
 
-    func->_ident = ctx->Ident()->getText();
-    func->_param = std::move(std::any_cast<std::shared_ptr<FuncFParamsNode>>(visitFuncFParams(ctx->funcFParams())));
-    func->_block = std::move(std::any_cast<std::shared_ptr<BlockNode>>(visitBlock(ctx->block())));
+    func->_ident = _arena.intern(ctx->Ident()->getText());
+    func->_param = buildFuncFParams(ctx->funcFParams());
+    func->_block = buildBlock(ctx->block());
 
     return func;
 }
 
-std::any ASTBuilder::visitBlock(l24Parser::BlockContext *ctx) {
-    auto block = std::make_shared<BlockNode>();
+ExternDeclNode *ASTBuilder::buildExternDecl(l24Parser::ExternDeclContext *ctx) {
+    auto extern_decl = _arena.create<ExternDeclNode>();
+    extern_decl->_ident = _arena.intern(ctx->Ident()->getText());
+    if (ctx->LeftParen()) {
+        extern_decl->_is_func = true;
+        if (ctx->Int() != nullptr) {
+            extern_decl->_type = _arena.copyString(ctx->Int()->getText());
+        } else {
+            extern_decl->_type = _arena.copyString(ctx->Void()->getText());
+        }
+        extern_decl->_param = buildFuncFParams(ctx->funcFParams());
+        return extern_decl;
+    }
+
+    extern_decl->_type = _arena.copyString(ctx->bType()->Int()->getText());
+    if (ctx->LeftSqrBr()) {
+        extern_decl->_is_array = true;
+        if (ctx->exp()) {
+            extern_decl->_exp = buildExp(ctx->exp());
+        }
+    }
+    return extern_decl;
+}
+
+BlockNode *ASTBuilder::buildBlock(l24Parser::BlockContext *ctx) {
+    auto block = _arena.create<BlockNode>();
+    std::vector<ASTNode *> block_items;
     for (auto blk_item_ctx : ctx->blockItem()) {
-        block->_block_items.push_back(std::move(std::any_cast<std::shared_ptr<BlockItemNode>>(visitBlockItem(blk_item_ctx))));
+        block_items.push_back(buildBlockItem(blk_item_ctx));
     }
+    block->_block_items = _arena.copyList(block_items);
     return block;
 }
 
 
-std::any ASTBuilder::visitStmt(l24Parser::StmtContext *ctx) {
-    auto stmt = std::make_shared<StmtNode>();
+StmtNode *ASTBuilder::buildStmt(l24Parser::StmtContext *ctx) {
+    auto stmt = _arena.create<StmtNode>();
     if (ctx->Return()) {
         stmt->_is_ret_stmt = true;
     }
 
     if (ctx->block()) {
-        stmt->_block = std::move(std::any_cast<std::shared_ptr<BlockNode>>(visitBlock(ctx->block())));
+        stmt->_block = buildBlock(ctx->block());
         return stmt;
     }
     if (ctx->Continue()) {
@@ -75,274 +104,252 @@ std::any ASTBuilder::visitStmt(l24Parser::StmtContext *ctx) {
     }
 
     if (ctx->lVal()) {
-        stmt->_l_val = ctx->lVal()->Ident()->getText();
+        stmt->_l_val = _arena.intern(ctx->lVal()->Ident()->getText());
         // array
         if (ctx->lVal()->exp()) {
-            stmt->_sub_idx = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->lVal()->exp())));
+            stmt->_sub_idx = buildExp(ctx->lVal()->exp());
         }
     }
     if (ctx->exp()) {
-        stmt->_expr = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->exp())));
+        stmt->_expr = buildExp(ctx->exp());
     }
     if (ctx->If()) {
-        stmt->_if_stmt = std::move(std::any_cast<std::shared_ptr<StmtNode>>(visitStmt(ctx->stmt()[0])));
-        if (ctx->stmt().size() == 2) {
-            stmt->_else_stmt = std::move(std::any_cast<std::shared_ptr<StmtNode>>(visitStmt(ctx->stmt()[1])));
+        stmt->_if_stmt = buildStmt(ctx->stmt(0));
+        if (ctx->stmt(1) != nullptr) {
+            stmt->_else_stmt = buildStmt(ctx->stmt(1));
         }
     }
     if (ctx->While()) {
-        stmt->_while_stmt = std::move(std::any_cast<std::shared_ptr<StmtNode>>(visitStmt(ctx->stmt()[0])));
+        stmt->_while_stmt = buildStmt(ctx->stmt(0));
     }
 
     return stmt;
 }
 
-std::any ASTBuilder::visitNumber(l24Parser::NumberContext *ctx) {
-    return std::make_shared<NumberNode>(std::stoll(ctx->IntLiteral()->getText()));
+ExprNode *ASTBuilder::buildNumber(l24Parser::NumberContext *ctx) {
+    auto token = ctx->IntLiteral()->getSymbol();
+    int64_t value = 0;
+    if (llvm::StringRef(token->getText()).getAsInteger(10, value)) {
+        // same message and position as NativeParser
+        _errors.syntaxError(nullptr, token, token->getLine(), token->getCharPositionInLine(),
+                            "integer literal out of range", nullptr);
+    }
+    return _arena.create<LiteralNode>(value);
 }
 
-std::any ASTBuilder::visitExp(l24Parser::ExpContext *ctx) {
-    auto expr = std::make_shared<ExprNode>();
-    expr->_lor_expr = std::move(std::any_cast<std::shared_ptr<LorExprNode>>(visitLOrExp(ctx->lOrExp())));
-    return expr;
+ExprNode *ASTBuilder::buildExp(l24Parser::ExpContext *ctx) {
+    return buildLOrExp(ctx->lOrExp());
 }
-std::any ASTBuilder::visitUnaryExp(l24Parser::UnaryExpContext *ctx) {
-    auto unary_expr = std::make_shared<UnaryExprNode>();
+ExprNode *ASTBuilder::buildUnaryExp(l24Parser::UnaryExpContext *ctx) {
     if (ctx->primaryExp()) {
-        unary_expr->_primary_expr = std::move(std::any_cast<std::shared_ptr<PrimExprNode>>(visitPrimaryExp(ctx->primaryExp())));
-    } else if (ctx->unaryExp() && ctx->unaryOp()){
-        unary_expr->_unary_op = std::move(std::any_cast<std::shared_ptr<UnaryOpNode>>(visitUnaryOp(ctx->unaryOp())));
-        unary_expr->_unary_expr = std::move(std::any_cast<std::shared_ptr<UnaryExprNode>>(visitUnaryExp(ctx->unaryExp())));
-    } else {
-        unary_expr->_func_ident = ctx->Ident()->getText();
-        unary_expr->_func_r_params = std::move(std::any_cast<std::shared_ptr<FuncRParamsNode>>(visitFuncRParams(ctx->funcRParams())));
+        return buildPrimaryExp(ctx->primaryExp());
     }
-    return unary_expr;
-}
-std::any ASTBuilder::visitUnaryOp(l24Parser::UnaryOpContext *ctx) {
-    std::shared_ptr<UnaryOpNode> unary_op;
-    if (ctx->Minus()) {
-        unary_op = std::make_shared<UnaryOpNode>(ctx->Minus()->getText());
-    } else if (ctx->Plus()) {
-        unary_op = std::make_shared<UnaryOpNode>(ctx->Plus()->getText());
-    } else if (ctx->Not()) {
-        unary_op = std::make_shared<UnaryOpNode>(ctx->Not()->getText());
-    } else {
-        ASTBuilder::BuildError("UnaryOp build failed");
+    if (ctx->unaryExp() && ctx->unaryOp()) {
+        auto unary_op = ctx->unaryOp();
+        auto operand = buildUnaryExp(ctx->unaryExp());
+        if (unary_op->Minus()) {
+            return _arena.create<UnaryExprNode>(UnaryOp::Neg, operand);
+        }
+        if (unary_op->Not()) {
+            return _arena.create<UnaryExprNode>(UnaryOp::Not, operand);
+        }
+        if (!unary_op->Plus()) {
+            ASTBuilder::BuildError("UnaryOp build failed");
+        }
+        // unary plus
+        return operand;
     }
-    return unary_op;
+    auto call = _arena.create<CallNode>();
+    call->_func_ident = _arena.intern(ctx->Ident()->getText());
+    call->_args = buildFuncRParams(ctx->funcRParams());
+    return call;
 }
 
-std::any ASTBuilder::visitPrimaryExp(l24Parser::PrimaryExpContext *ctx) {
-    auto prim_exp = std::make_shared<PrimExprNode>();
+ExprNode *ASTBuilder::buildPrimaryExp(l24Parser::PrimaryExpContext *ctx) {
     if (ctx->exp()) {
-        prim_exp->_expr = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->exp())));
-    } else if (ctx->number()){
-        prim_exp->_number = std::move(std::any_cast<std::shared_ptr<NumberNode>>(visitNumber(ctx->number())));
-    } else {
-        prim_exp->_l_val = std::move(std::any_cast<std::shared_ptr<LValNode>>(visitLVal(ctx->lVal())));
+        return buildExp(ctx->exp());
     }
-    return prim_exp;
+    if (ctx->number()) {
+        return buildNumber(ctx->number());
+    }
+    return buildLVal(ctx->lVal());
 }
-std::any ASTBuilder::visitAddExp(l24Parser::AddExpContext *ctx) {
-    auto add_exp = std::make_shared<AddExprNode>();
-    if (ctx->Plus() || ctx->Minus()) {
-        if (ctx->Plus()) {
-            add_exp->_op = ctx->Plus()->getText()[0];
-        } else {
-            add_exp->_op = ctx->Minus()->getText()[0];
-        }
-        add_exp->_add_expr = std::move(std::any_cast<std::shared_ptr<AddExprNode>>(visitAddExp(ctx->addExp())));
-        add_exp->_mul_expr = std::move(std::any_cast<std::shared_ptr<MulExprNode>>(visitMulExp(ctx->mulExp())));
-    } else {
-        add_exp->_mul_expr = std::move(std::any_cast<std::shared_ptr<MulExprNode>>(visitMulExp(ctx->mulExp())));
+ExprNode *ASTBuilder::buildAddExp(l24Parser::AddExpContext *ctx) {
+    if (!ctx->addExp()) {
+        return buildMulExp(ctx->mulExp());
     }
-    return add_exp;
+    auto lhs = buildAddExp(ctx->addExp());
+    auto op = ctx->Plus() ? BinaryOp::Add : BinaryOp::Sub;
+    return _arena.create<BinaryExprNode>(op, lhs, buildMulExp(ctx->mulExp()));
 }
-std::any ASTBuilder::visitMulExp(l24Parser::MulExpContext *ctx) {
-    auto mul_exp = std::make_shared<MulExprNode>();
-    if (ctx->Slash() || ctx->Star() || ctx->Percentage()) {
-        if (ctx->Slash()) {
-            mul_exp->_op = ctx->Slash()->getText()[0];
-        } else if (ctx->Star()) {
-            mul_exp->_op = ctx->Star()->getText()[0];
-        } else {
-            mul_exp->_op = ctx->Percentage()->getText()[0];
-        }
-        mul_exp->_unary_expr = std::move(std::any_cast<std::shared_ptr<UnaryExprNode>>(visitUnaryExp(ctx->unaryExp())));
-        mul_exp->_mul_expr = std::move(std::any_cast<std::shared_ptr<MulExprNode>>(visitMulExp(ctx->mulExp())));
-    } else {
-        mul_exp->_unary_expr = std::move(std::any_cast<std::shared_ptr<UnaryExprNode>>(visitUnaryExp(ctx->unaryExp())));
+ExprNode *ASTBuilder::buildMulExp(l24Parser::MulExpContext *ctx) {
+    if (!ctx->mulExp()) {
+        return buildUnaryExp(ctx->unaryExp());
     }
-    return mul_exp;
+    auto lhs = buildMulExp(ctx->mulExp());
+    auto op = ctx->Star() ? BinaryOp::Mul : ctx->Slash() ? BinaryOp::Div : BinaryOp::Rem;
+    return _arena.create<BinaryExprNode>(op, lhs, buildUnaryExp(ctx->unaryExp()));
 }
-std::any ASTBuilder::visitLOrExp(l24Parser::LOrExpContext *ctx) {
-    auto lor_expr = std::make_shared<LorExprNode>();
-    if (ctx->lAndExp() && ctx->lOrExp()) {
-        lor_expr->_land_expr = std::move(std::any_cast<std::shared_ptr<LandExprNode>>(visitLAndExp(ctx->lAndExp())));
-        lor_expr->_lor_expr = std::move(std::any_cast<std::shared_ptr<LorExprNode>>(visitLOrExp(ctx->lOrExp())));
-    } else {
-        lor_expr->_land_expr = std::move(std::any_cast<std::shared_ptr<LandExprNode>>(visitLAndExp(ctx->lAndExp())));
+ExprNode *ASTBuilder::buildLOrExp(l24Parser::LOrExpContext *ctx) {
+    if (!ctx->lOrExp()) {
+        return buildLAndExp(ctx->lAndExp());
     }
-    return lor_expr;
+    auto lhs = buildLOrExp(ctx->lOrExp());
+    return _arena.create<BinaryExprNode>(BinaryOp::Or, lhs, buildLAndExp(ctx->lAndExp()));
 }
-std::any ASTBuilder::visitLAndExp(l24Parser::LAndExpContext *ctx) {
-    auto land_expr = std::make_shared<LandExprNode>();
-    if (ctx->lAndExp() && ctx->eqExp()) {
-        land_expr->_land_expr = std::move(std::any_cast<std::shared_ptr<LandExprNode>>(visitLAndExp(ctx->lAndExp())));
-        land_expr->_eq_expr = std::move(std::any_cast<std::shared_ptr<EqExprNode>>(visitEqExp(ctx->eqExp())));
-    } else {
-        land_expr->_eq_expr = std::move(std::any_cast<std::shared_ptr<EqExprNode>>(visitEqExp(ctx->eqExp())));
+ExprNode *ASTBuilder::buildLAndExp(l24Parser::LAndExpContext *ctx) {
+    if (!ctx->lAndExp()) {
+        return buildEqExp(ctx->eqExp());
     }
-    return land_expr;
+    auto lhs = buildLAndExp(ctx->lAndExp());
+    return _arena.create<BinaryExprNode>(BinaryOp::And, lhs, buildEqExp(ctx->eqExp()));
 }
-std::any ASTBuilder::visitEqExp(l24Parser::EqExpContext *ctx) {
-    auto eq_expr = std::make_shared<EqExprNode>();
-    if (ctx->eqExp() && ctx->relExp()) {
-        if (ctx->Eq()) {
-            eq_expr->op = ctx->Eq()->getText();
-        } else {
-            eq_expr->op = ctx->NotEq()->getText();
-        }
-        eq_expr->_rel_expr = std::move(std::any_cast<std::shared_ptr<RelExprNode>>(visitRelExp(ctx->relExp())));
-        eq_expr->_eq_expr = std::move(std::any_cast<std::shared_ptr<EqExprNode>>(visitEqExp(ctx->eqExp())));
-    } else {
-        eq_expr->_rel_expr = std::move(std::any_cast<std::shared_ptr<RelExprNode>>(visitRelExp(ctx->relExp())));
+ExprNode *ASTBuilder::buildEqExp(l24Parser::EqExpContext *ctx) {
+    if (!ctx->eqExp()) {
+        return buildRelExp(ctx->relExp());
     }
-    return eq_expr;
+    auto lhs = buildEqExp(ctx->eqExp());
+    auto op = ctx->Eq() ? BinaryOp::Eq : BinaryOp::Ne;
+    return _arena.create<BinaryExprNode>(op, lhs, buildRelExp(ctx->relExp()));
 }
-std::any ASTBuilder::visitRelExp(l24Parser::RelExpContext *ctx) {
-    auto rel_expr = std::make_shared<RelExprNode>();
-    if (ctx->relExp() && ctx->addExp()) {
-        if (ctx->Less()) {
-            rel_expr->op = ctx->Less()->getText();
-        } else if (ctx->Greater()){
-            rel_expr->op = ctx->Greater()->getText();
-        } else if (ctx->LessEq()) {
-            rel_expr->op = ctx->LessEq()->getText();
-        } else {
-            rel_expr->op = ctx->GreaterEq()->getText();
-        }
-        rel_expr->_add_expr = std::move(std::any_cast<std::shared_ptr<AddExprNode>>(visitAddExp(ctx->addExp())));
-        rel_expr->_rel_expr = std::move(std::any_cast<std::shared_ptr<RelExprNode>>(visitRelExp(ctx->relExp())));
+ExprNode *ASTBuilder::buildRelExp(l24Parser::RelExpContext *ctx) {
+    if (!ctx->relExp()) {
+        return buildAddExp(ctx->addExp());
+    }
+    auto lhs = buildRelExp(ctx->relExp());
+    BinaryOp op;
+    if (ctx->Less()) {
+        op = BinaryOp::Lt;
+    } else if (ctx->Greater()) {
+        op = BinaryOp::Gt;
+    } else if (ctx->LessEq()) {
+        op = BinaryOp::Le;
     } else {
-        rel_expr->_add_expr = std::move(std::any_cast<std::shared_ptr<AddExprNode>>(visitAddExp(ctx->addExp())));
+        op = BinaryOp::Ge;
     }
-    return rel_expr;
+    return _arena.create<BinaryExprNode>(op, lhs, buildAddExp(ctx->addExp()));
 }
-std::any ASTBuilder::visitBlockItem(l24Parser::BlockItemContext *ctx) {
-    auto blk_item_node = std::make_shared<BlockItemNode>();
+BlockItemNode *ASTBuilder::buildBlockItem(l24Parser::BlockItemContext *ctx) {
+    auto blk_item_node = _arena.create<BlockItemNode>();
     if (ctx->decl()) {
-        blk_item_node->_decl = std::move(std::any_cast<std::shared_ptr<DeclNode>>(visitDecl(ctx->decl())));
+        blk_item_node->_decl = buildDecl(ctx->decl());
     } else {
-        blk_item_node->_stmt = std::move(std::any_cast<std::shared_ptr<StmtNode>>(visitStmt(ctx->stmt())));
+        blk_item_node->_stmt = buildStmt(ctx->stmt());
     }
     return blk_item_node;
 }
 
-std::any ASTBuilder::visitDecl(l24Parser::DeclContext *ctx) {
-    auto decl_node = std::make_shared<DeclNode>();
+DeclNode *ASTBuilder::buildDecl(l24Parser::DeclContext *ctx) {
+    auto decl_node = _arena.create<DeclNode>();
     if (ctx->constDecl()) {
-        decl_node->_const_decl = std::move(std::any_cast<std::shared_ptr<ConstDeclNode>>(visitConstDecl(ctx->constDecl())));
+        decl_node->_const_decl = buildConstDecl(ctx->constDecl());
     } else {
-        decl_node->_var_decl = std::move(std::any_cast<std::shared_ptr<VarDeclNode>>(visitVarDecl(ctx->varDecl())));
+        decl_node->_var_decl = buildVarDecl(ctx->varDecl());
     }
     return decl_node;
 }
 
-std::any ASTBuilder::visitConstDecl(l24Parser::ConstDeclContext *ctx) {
-    auto const_decl_node = std::make_shared<ConstDeclNode>();
-    const_decl_node->_b_type = ctx->bType()->Int()->getText();
+ConstDeclNode *ASTBuilder::buildConstDecl(l24Parser::ConstDeclContext *ctx) {
+    auto const_decl_node = _arena.create<ConstDeclNode>();
+    const_decl_node->_b_type = _arena.copyString(ctx->bType()->Int()->getText());
+    std::vector<ASTNode *> const_defs;
     for (auto const_def_ctx : ctx->constDef()) {
-        const_decl_node->_const_defs.push_back(std::move(std::any_cast<std::shared_ptr<ConstDefNode>>(visitConstDef(const_def_ctx))));
+        const_defs.push_back(buildConstDef(const_def_ctx));
     }
+    const_decl_node->_const_defs = _arena.copyList(const_defs);
     return const_decl_node;
 }
 
-std::any ASTBuilder::visitVarDecl(l24Parser::VarDeclContext *ctx)  {
-    auto var_decl_node = std::make_shared<VarDeclNode>();
-    var_decl_node->_b_type = ctx->bType()->Int()->getText();
+VarDeclNode *ASTBuilder::buildVarDecl(l24Parser::VarDeclContext *ctx)  {
+    auto var_decl_node = _arena.create<VarDeclNode>();
+    var_decl_node->_b_type = _arena.copyString(ctx->bType()->Int()->getText());
+    std::vector<ASTNode *> var_defs;
     for (auto var_def_ctx : ctx->varDef()) {
-        var_decl_node->_var_defs.push_back(std::move(std::any_cast<std::shared_ptr<VarDefNode>>(visitVarDef(var_def_ctx))));
+        var_defs.push_back(buildVarDef(var_def_ctx));
     }
+    var_decl_node->_var_defs = _arena.copyList(var_defs);
     return var_decl_node;
 }
-std::any ASTBuilder::visitConstDef(l24Parser::ConstDefContext *ctx) {
-    auto const_def_node = std::make_shared<ConstDefNode>();
-    const_def_node->_ident = ctx->Ident()->getText();
-    const_def_node->_init_val = std::move(std::any_cast<std::shared_ptr<InitValNode>>(visitInitVal(ctx->initVal())));
+ConstDefNode *ASTBuilder::buildConstDef(l24Parser::ConstDefContext *ctx) {
+    auto const_def_node = _arena.create<ConstDefNode>();
+    const_def_node->_ident = _arena.intern(ctx->Ident()->getText());
+    const_def_node->_init_val = buildInitVal(ctx->initVal());
     if (ctx->exp() != nullptr) {
-        const_def_node->_exp = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->exp())));
+        const_def_node->_exp = buildExp(ctx->exp());
     }
     return const_def_node;
 }
 
-std::any ASTBuilder::visitVarDef(l24Parser::VarDefContext *ctx) {
-    auto var_def_node = std::make_shared<VarDefNode>();
-    var_def_node->_ident = ctx->Ident()->getText();
+VarDefNode *ASTBuilder::buildVarDef(l24Parser::VarDefContext *ctx) {
+    auto var_def_node = _arena.create<VarDefNode>();
+    var_def_node->_ident = _arena.intern(ctx->Ident()->getText());
     if (ctx->initVal()) {
-        var_def_node->_init_val = std::move(std::any_cast<std::shared_ptr<InitValNode>>(visitInitVal(ctx->initVal())));
+        var_def_node->_init_val = buildInitVal(ctx->initVal());
     }
     if (ctx->exp()) {
-        var_def_node->_exp = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->exp())));
+        var_def_node->_exp = buildExp(ctx->exp());
     }
     return var_def_node;
 }
 
-std::any ASTBuilder::visitInitVal(l24Parser::InitValContext *ctx) {
-    auto init_val_node = std::make_shared<InitValNode>();
+InitValNode *ASTBuilder::buildInitVal(l24Parser::InitValContext *ctx) {
+    auto init_val_node = _arena.create<InitValNode>();
     if (ctx->LeftBrace() || ctx->StringLiteral()) {
         init_val_node->_is_array = true;
     }
     if (ctx->StringLiteral()) {
         std::string str_with_quote = ctx->StringLiteral()->getText();
-        init_val_node->_string_literal = str_with_quote.substr(1, str_with_quote.length() - 2);
+        init_val_node->_string_literal = _arena.copyString(llvm::StringRef(str_with_quote).drop_front().drop_back());
     }
+    std::vector<ASTNode *> exps;
     for (auto exp_ctx_node : ctx->exp()) {
-        init_val_node->_exp.push_back(std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(exp_ctx_node))));
+        exps.push_back(buildExp(exp_ctx_node));
     }
+    init_val_node->_exp = _arena.copyList(exps);
     return init_val_node;
 }
 
-std::any ASTBuilder::visitLVal(l24Parser::LValContext *ctx) {
-    auto l_val_node = std::make_shared<LValNode>();
-    l_val_node->_ident = ctx->Ident()->getText();
+ExprNode *ASTBuilder::buildLVal(l24Parser::LValContext *ctx) {
+    auto var_ref = _arena.create<VarRefNode>();
+    var_ref->_ident = _arena.intern(ctx->Ident()->getText());
     if (ctx->exp() != nullptr) {
-        l_val_node->_exp = std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(ctx->exp())));
+        var_ref->_exp = buildExp(ctx->exp());
     }
-    return l_val_node;
+    return var_ref;
 }
 
-std::any ASTBuilder::visitFuncFParams(l24Parser::FuncFParamsContext *ctx) {
-    auto func_f_params_node = std::make_shared<FuncFParamsNode>();
+FuncFParamsNode *ASTBuilder::buildFuncFParams(l24Parser::FuncFParamsContext *ctx) {
+    auto func_f_params_node = _arena.create<FuncFParamsNode>();
     if (ctx == nullptr) {
         return func_f_params_node;
     }
+    std::vector<ASTNode *> params;
     for (auto func_f_param_ctx : ctx->funcFParam()) {
-        func_f_params_node->_params.push_back(std::move(std::any_cast<std::shared_ptr<FuncFParamNode>>(visitFuncFParam(func_f_param_ctx))));
+        params.push_back(buildFuncFParam(func_f_param_ctx));
     }
+    func_f_params_node->_params = _arena.copyList(params);
     return func_f_params_node;
 }
-std::any ASTBuilder::visitFuncFParam(l24Parser::FuncFParamContext *ctx) {
-    auto func_f_param_node = std::make_shared<FuncFParamNode>();
+FuncFParamNode *ASTBuilder::buildFuncFParam(l24Parser::FuncFParamContext *ctx) {
+    auto func_f_param_node = _arena.create<FuncFParamNode>();
     // pointer
     if (ctx->LeftSqrBr()) {
         func_f_param_node->_type = "pointer";
     } else {
-        func_f_param_node->_type = ctx->Int()->getText();
+        func_f_param_node->_type = _arena.copyString(ctx->Int()->getText());
     }
-    func_f_param_node->_ident = ctx->Ident()->getText();
+    func_f_param_node->_ident = _arena.intern(ctx->Ident()->getText());
     return func_f_param_node;
 }
-std::any ASTBuilder::visitFuncRParams(l24Parser::FuncRParamsContext *ctx) {
-    auto func_r_params_node = std::make_shared<FuncRParamsNode>();
+llvm::ArrayRef<ExprNode *> ASTBuilder::buildFuncRParams(l24Parser::FuncRParamsContext *ctx) {
     if (ctx == nullptr) {
-        return func_r_params_node;
+        return {};
     }
+    std::vector<ExprNode *> args;
     for (auto exp_ctx : ctx->exp()) {
-        func_r_params_node->_exps.push_back(std::move(std::any_cast<std::shared_ptr<ExprNode>>(visitExp(exp_ctx))));
+        args.push_back(buildExp(exp_ctx));
     }
-    return func_r_params_node;
+    return _arena.copyList(args);
 }
 
 } // namespace l24
@@ -1,53 +1,66 @@
 #pragma once
 
-#include <memory>
-
-#include <any>
-
 #include "antlr4-runtime.h"
-#include "l24BaseVisitor.h"
+#include "l24Parser.h"
+
+#include "llvm/ADT/ArrayRef.h"
 
 #include "frontend/ast.h"
+#include "frontend/ast_arena.h"
 
 namespace l24 {
 
-class ASTBuilder : public l24BaseVisitor {
+// Build the AST by direct recursion over the typed contexts of the parse tree, one
+// top-level item at a time.
+// Unlike a generated visitor, every build function returns its node type, so nodes are
+// never boxed in std::any and cast back at the call site.
+class ASTBuilder {
 public:
-    std::shared_ptr<ASTNode> build(l24Parser::EntryContext *ctx);
+    // nodes are allocated in arena, errors in the tokens that the parser accepted
+    // (integer literals out of range) are reported to errors
+    ASTBuilder(ASTArena &arena, antlr4::ANTLRErrorListener &errors):
+        _arena(arena), _errors(errors) {}
+
+    // the AST of one top-level item, items are collected in source order by the caller
+    ItemNode *buildItem(l24Parser::ItemContext *ctx);
+    // these only wrap nodes that are already built
+    static ProgNode *buildProgram(ASTArena &arena, llvm::ArrayRef<ASTNode *> items);
+    static EntryNode *buildEntry(ASTArena &arena, ProgNode *program);
 
     static void BuildError(const char *str) {
         std::cerr << str << std::endl;
     }
-    std::any visitEntry(l24Parser::EntryContext *ctx) override;
-    std::any visitProgram(l24Parser::ProgramContext *ctx) override;
-    std::any visitFunc(l24Parser::FuncContext *ctx) override;
-    std::any visitFuncFParams(l24Parser::FuncFParamsContext *ctx) override;
-    std::any visitFuncFParam(l24Parser::FuncFParamContext *ctx) override;
-    std::any visitFuncRParams(l24Parser::FuncRParamsContext *ctx) override;
-    std::any visitBlock(l24Parser::BlockContext *ctx) override;
-    std::any visitBlockItem(l24Parser::BlockItemContext *ctx) override;
-    std::any visitDecl(l24Parser::DeclContext *ctx) override;
-    std::any visitConstDecl(l24Parser::ConstDeclContext *ctx) override;
-    std::any visitVarDecl(l24Parser::VarDeclContext *ctx) override;
-    std::any visitConstDef(l24Parser::ConstDefContext *ctx) override;
-    std::any visitVarDef(l24Parser::VarDefContext *ctx) override;
-    std::any visitInitVal(l24Parser::InitValContext *ctx) override;
-
-    std::any visitStmt(l24Parser::StmtContext *ctx) override;
-    std::any visitNumber(l24Parser::NumberContext *ctx) override;
-    std::any visitExp(l24Parser::ExpContext *ctx) override;
-    std::any visitAddExp(l24Parser::AddExpContext *ctx) override;
-    std::any visitMulExp(l24Parser::MulExpContext *ctx) override;
-    std::any visitUnaryExp(l24Parser::UnaryExpContext *ctx) override;
-    std::any visitUnaryOp(l24Parser::UnaryOpContext *ctx) override;
-    std::any visitPrimaryExp(l24Parser::PrimaryExpContext *ctx) override;
-    std::any visitLOrExp(l24Parser::LOrExpContext *ctx) override;
-    std::any visitLAndExp(l24Parser::LAndExpContext *ctx) override;
-    std::any visitEqExp(l24Parser::EqExpContext *ctx) override;
-    std::any visitRelExp(l24Parser::RelExpContext *ctx) override;
-    std::any visitLVal(l24Parser::LValContext *ctx) override;
 
+private:
+    FuncNode *buildFunc(l24Parser::FuncContext *ctx);
+    ExternDeclNode *buildExternDecl(l24Parser::ExternDeclContext *ctx);
+    FuncFParamsNode *buildFuncFParams(l24Parser::FuncFParamsContext *ctx);
+    FuncFParamNode *buildFuncFParam(l24Parser::FuncFParamContext *ctx);
+    llvm::ArrayRef<ExprNode *> buildFuncRParams(l24Parser::FuncRParamsContext *ctx);
+    BlockNode *buildBlock(l24Parser::BlockContext *ctx);
+    BlockItemNode *buildBlockItem(l24Parser::BlockItemContext *ctx);
+    DeclNode *buildDecl(l24Parser::DeclContext *ctx);
+    ConstDeclNode *buildConstDecl(l24Parser::ConstDeclContext *ctx);
+    VarDeclNode *buildVarDecl(l24Parser::VarDeclContext *ctx);
+    ConstDefNode *buildConstDef(l24Parser::ConstDefContext *ctx);
+    VarDefNode *buildVarDef(l24Parser::VarDefContext *ctx);
+    InitValNode *buildInitVal(l24Parser::InitValContext *ctx);
+
+    StmtNode *buildStmt(l24Parser::StmtContext *ctx);
+    ExprNode *buildNumber(l24Parser::NumberContext *ctx);
+    ExprNode *buildExp(l24Parser::ExpContext *ctx);
+    ExprNode *buildAddExp(l24Parser::AddExpContext *ctx);
+    ExprNode *buildMulExp(l24Parser::MulExpContext *ctx);
+    ExprNode *buildUnaryExp(l24Parser::UnaryExpContext *ctx);
+    ExprNode *buildPrimaryExp(l24Parser::PrimaryExpContext *ctx);
+    ExprNode *buildLOrExp(l24Parser::LOrExpContext *ctx);
+    ExprNode *buildLAndExp(l24Parser::LAndExpContext *ctx);
+    ExprNode *buildEqExp(l24Parser::EqExpContext *ctx);
+    ExprNode *buildRelExp(l24Parser::RelExpContext *ctx);
+    ExprNode *buildLVal(l24Parser::LValContext *ctx);
 
+    ASTArena &_arena;
+    antlr4::ANTLRErrorListener &_errors;
 };
 
 } // namespace l24
@@ -0,0 +1,823 @@
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/LEB128.h"
+
+#include "frontend/ast_serializer.h"
+
+namespace l24 {
+
+namespace {
+constexpr char Magic[] = {'L', '2', '4', 'A', 'S', 'T'};
+// bump whenever a node or the encoding changes
+constexpr uint8_t Version = 1;
+// deepest nesting of statements, blocks and expressions the reader accepts, well within
+// the stack. the left operands of a chain like a + b + c don't count, see readExpr
+constexpr unsigned MaxDepth = 10000;
+
+enum class NodeKind : uint8_t {
+    Null,
+    Prog,
+    Item,
+    ExternDecl,
+    Func,
+    FuncFParams,
+    FuncFParam,
+    Block,
+    BlockItem,
+    Decl,
+    ConstDecl,
+    VarDecl,
+    ConstDef,
+    VarDef,
+    InitVal,
+    Stmt,
+    Binary,
+    Unary,
+    Literal,
+    VarRef,
+    Call,
+};
+
+// flags of ExternDeclNode and StmtNode
+constexpr uint8_t IsFunc = 1, IsArray = 2;
+constexpr uint8_t IsReturn = 1, IsContinue = 2, IsBreak = 4;
+
+class ASTWriter {
+public:
+    explicit ASTWriter(const SymbolTable &symbols): _symbols(symbols), _os(_nodes) {}
+
+    void writeEntry(const EntryNode &entry, llvm::raw_ostream &os);
+
+private:
+    // write the kind of node, or NodeKind::Null if it is nullptr
+    bool begin(const ASTNode *node, NodeKind kind) {
+        writeByte(static_cast<uint8_t>(node != nullptr ? kind : NodeKind::Null));
+        return node != nullptr;
+    }
+    void writeByte(uint8_t byte) { _os << static_cast<char>(byte); }
+    void writeUInt(uint64_t value) { llvm::encodeULEB128(value, _os); }
+    void writeInt(int64_t value) { llvm::encodeSLEB128(value, _os); }
+    void writeString(llvm::StringRef str) {
+        writeUInt(str.size());
+        _os << str;
+    }
+    // 0 is NoSymbol, other names are numbered from 1 in the order of their first use
+    void writeSymbol(Symbol symbol);
+
+    void writeProg(const ASTNode *node);
+    void writeItem(const ASTNode *node);
+    void writeExternDecl(const ASTNode *node);
+    void writeFunc(const ASTNode *node);
+    void writeFuncFParams(const ASTNode *node);
+    void writeFuncFParam(const ASTNode *node);
+    void writeBlock(const ASTNode *node);
+    void writeBlockItem(const ASTNode *node);
+    void writeDecl(const ASTNode *node);
+    void writeConstDecl(const ASTNode *node);
+    void writeVarDecl(const ASTNode *node);
+    void writeConstDef(const ASTNode *node);
+    void writeVarDef(const ASTNode *node);
+    void writeInitVal(const ASTNode *node);
+    void writeStmt(const ASTNode *node);
+    void writeExpr(const ASTNode *node);
+
+    const SymbolTable &_symbols;
+    // file index of every Symbol written so far, and the names in that order
+    llvm::DenseMap<Symbol, uint64_t> _indices;
+    std::vector<llvm::StringRef> _names;
+    // the nodes are written before the names, which are only known afterwards
+    std::string _nodes;
+    llvm::raw_string_ostream _os;
+};
+
+void ASTWriter::writeEntry(const EntryNode &entry, llvm::raw_ostream &os) {
+    // the Symbols of a source parsed on several threads are numbered in the order the
+    // threads interned them, the first use in the tree gives the same file every time
+    writeProg(entry._prog);
+    os.write(Magic, sizeof(Magic));
+    os << static_cast<char>(Version);
+    llvm::encodeULEB128(_names.size(), os);
+    for (auto name : _names) {
+        llvm::encodeULEB128(name.size(), os);
+        os << name;
+    }
+    os << _os.str();
+}
+
+void ASTWriter::writeSymbol(Symbol symbol) {
+    if (symbol == NoSymbol) {
+        writeUInt(0);
+        return;
+    }
+    auto [it, inserted] = _indices.try_emplace(symbol, _names.size() + 1);
+    if (inserted) {
+        _names.push_back(_symbols.name(symbol));
+    }
+    writeUInt(it->second);
+}
+
+void ASTWriter::writeProg(const ASTNode *node) {
+    auto prog = dynamic_cast<const ProgNode *>(node);
+    if (!begin(prog, NodeKind::Prog)) {
+        return;
+    }
+    writeUInt(prog->_items.size());
+    for (auto item : prog->_items) {
+        writeItem(item);
+    }
+}
+
+void ASTWriter::writeItem(const ASTNode *node) {
+    auto item = dynamic_cast<const ItemNode *>(node);
+    if (!begin(item, NodeKind::Item)) {
+        return;
+    }
+    writeDecl(item->_decl);
+    writeFunc(item->_func);
+    writeExternDecl(item->_extern_decl);
+}
+
+void ASTWriter::writeExternDecl(const ASTNode *node) {
+    auto extern_decl = dynamic_cast<const ExternDeclNode *>(node);
+    if (!begin(extern_decl, NodeKind::ExternDecl)) {
+        return;
+    }
+    writeByte((extern_decl->_is_func ? IsFunc : 0) | (extern_decl->_is_array ? IsArray : 0));
+    writeString(extern_decl->_type);
+    writeSymbol(extern_decl->_ident);
+    writeFuncFParams(extern_decl->_param);
+    writeExpr(extern_decl->_exp);
+}
+
+void ASTWriter::writeFunc(const ASTNode *node) {
+    auto func = dynamic_cast<const FuncNode *>(node);
+    if (!begin(func, NodeKind::Func)) {
+        return;
+    }
+    writeString(func->_type);
+    writeSymbol(func->_ident);
+    writeFuncFParams(func->_param);
+    writeBlock(func->_block);
+}
+
+void ASTWriter::writeFuncFParams(const ASTNode *node) {
+    auto params = dynamic_cast<const FuncFParamsNode *>(node);
+    if (!begin(params, NodeKind::FuncFParams)) {
+        return;
+    }
+    writeUInt(params->_params.size());
+    for (auto param : params->_params) {
+        writeFuncFParam(param);
+    }
+}
+
+void ASTWriter::writeFuncFParam(const ASTNode *node) {
+    auto param = dynamic_cast<const FuncFParamNode *>(node);
+    if (!begin(param, NodeKind::FuncFParam)) {
+        return;
+    }
+    writeString(param->_type);
+    writeSymbol(param->_ident);
+}
+
+void ASTWriter::writeBlock(const ASTNode *node) {
+    auto block = dynamic_cast<const BlockNode *>(node);
+    if (!begin(block, NodeKind::Block)) {
+        return;
+    }
+    writeUInt(block->_block_items.size());
+    for (auto block_item : block->_block_items) {
+        writeBlockItem(block_item);
+    }
+}
+
+void ASTWriter::writeBlockItem(const ASTNode *node) {
+    auto block_item = dynamic_cast<const BlockItemNode *>(node);
+    if (!begin(block_item, NodeKind::BlockItem)) {
+        return;
+    }
+    writeDecl(block_item->_decl);
+    writeStmt(block_item->_stmt);
+}
+
+void ASTWriter::writeDecl(const ASTNode *node) {
+    auto decl = dynamic_cast<const DeclNode *>(node);
+    if (!begin(decl, NodeKind::Decl)) {
+        return;
+    }
+    writeConstDecl(decl->_const_decl);
+    writeVarDecl(decl->_var_decl);
+}
+
+void ASTWriter::writeConstDecl(const ASTNode *node) {
+    auto const_decl = dynamic_cast<const ConstDeclNode *>(node);
+    if (!begin(const_decl, NodeKind::ConstDecl)) {
+        return;
+    }
+    writeString(const_decl->_b_type);
+    writeUInt(const_decl->_const_defs.size());
+    for (auto const_def : const_decl->_const_defs) {
+        writeConstDef(const_def);
+    }
+}
+
+void ASTWriter::writeVarDecl(const ASTNode *node) {
+    auto var_decl = dynamic_cast<const VarDeclNode *>(node);
+    if (!begin(var_decl, NodeKind::VarDecl)) {
+        return;
+    }
+    writeString(var_decl->_b_type);
+    writeUInt(var_decl->_var_defs.size());
+    for (auto var_def : var_decl->_var_defs) {
+        writeVarDef(var_def);
+    }
+}
+
+void ASTWriter::writeConstDef(const ASTNode *node) {
+    auto const_def = dynamic_cast<const ConstDefNode *>(node);
+    if (!begin(const_def, NodeKind::ConstDef)) {
+        return;
+    }
+    writeSymbol(const_def->_ident);
+    writeInitVal(const_def->_init_val);
+    writeExpr(const_def->_exp);
+}
+
+void ASTWriter::writeVarDef(const ASTNode *node) {
+    auto var_def = dynamic_cast<const VarDefNode *>(node);
+    if (!begin(var_def, NodeKind::VarDef)) {
+        return;
+    }
+    writeSymbol(var_def->_ident);
+    writeInitVal(var_def->_init_val);
+    writeExpr(var_def->_exp);
+}
+
+void ASTWriter::writeInitVal(const ASTNode *node) {
+    auto init_val = dynamic_cast<const InitValNode *>(node);
+    if (!begin(init_val, NodeKind::InitVal)) {
+        return;
+    }
+    writeByte(init_val->_is_array);
+    writeString(init_val->_string_literal);
+    writeUInt(init_val->_exp.size());
+    for (auto exp : init_val->_exp) {
+        writeExpr(exp);
+    }
+}
+
+void ASTWriter::writeStmt(const ASTNode *node) {
+    auto stmt = dynamic_cast<const StmtNode *>(node);
+    if (!begin(stmt, NodeKind::Stmt)) {
+        return;
+    }
+    writeByte((stmt->_is_ret_stmt ? IsReturn : 0) | (stmt->_is_continue_stmt ? IsContinue : 0) |
+              (stmt->_is_break_stmt ? IsBreak : 0));
+    writeSymbol(stmt->_l_val);
+    writeExpr(stmt->_sub_idx);
+    writeExpr(stmt->_expr);
+    writeBlock(stmt->_block);
+    writeStmt(stmt->_if_stmt);
+    writeStmt(stmt->_else_stmt);
+    writeStmt(stmt->_while_stmt);
+}
+
+void ASTWriter::writeExpr(const ASTNode *node) {
+    auto expr = static_cast<const ExprNode *>(node);
+    if (expr == nullptr) {
+        writeByte(static_cast<uint8_t>(NodeKind::Null));
+        return;
+    }
+    switch (expr->_kind) {
+    case ExprNode::Kind::Binary: {
+        auto binary = static_cast<const BinaryExprNode *>(expr);
+        writeByte(static_cast<uint8_t>(NodeKind::Binary));
+        writeByte(static_cast<uint8_t>(binary->_op));
+        writeExpr(binary->_lhs);
+        writeExpr(binary->_rhs);
+        break;
+    }
+    case ExprNode::Kind::Unary: {
+        auto unary = static_cast<const UnaryExprNode *>(expr);
+        writeByte(static_cast<uint8_t>(NodeKind::Unary));
+        writeByte(static_cast<uint8_t>(unary->_op));
+        writeExpr(unary->_operand);
+        break;
+    }
+    case ExprNode::Kind::Literal:
+        writeByte(static_cast<uint8_t>(NodeKind::Literal));
+        writeInt(static_cast<const LiteralNode *>(expr)->_int_literal);
+        break;
+    case ExprNode::Kind::VarRef: {
+        auto var_ref = static_cast<const VarRefNode *>(expr);
+        writeByte(static_cast<uint8_t>(NodeKind::VarRef));
+        writeSymbol(var_ref->_ident);
+        writeExpr(var_ref->_exp);
+        break;
+    }
+    case ExprNode::Kind::Call: {
+        auto call = static_cast<const CallNode *>(expr);
+        writeByte(static_cast<uint8_t>(NodeKind::Call));
+        writeSymbol(call->_func_ident);
+        writeUInt(call->_args.size());
+        for (auto arg : call->_args) {
+            writeExpr(arg);
+        }
+        break;
+    }
+    }
+}
+
+class ASTReader {
+public:
+    ASTReader(llvm::StringRef data, ASTArena &arena): _data(data), _arena(arena) {}
+
+    // nullptr and _error set if the data is no valid AST file
+    EntryNode *readEntry();
+    const std::string &error() const { return _error; }
+
+private:
+    // thrown at the first malformed byte, after _error is set
+    struct FormatError {};
+
+    [[noreturn]] void error(const std::string &msg);
+    uint8_t readByte();
+    uint64_t readUInt();
+    int64_t readInt();
+    llvm::StringRef readString();
+    // NoSymbol for 0
+    Symbol readSymbol();
+    // an identifier codegen looks up, which must not be NoSymbol
+    Symbol readRequiredSymbol();
+    // a list length, each element takes at least one more byte
+    size_t readCount();
+    // read the kind of the next node, false for a null node and an error for any kind
+    // but kind
+    bool begin(NodeKind kind);
+    // a child that codegen doesn't expect to be null
+    template <typename T>
+    T *required(T *node) {
+        if (node == nullptr) {
+            error("missing node");
+        }
+        return node;
+    }
+    // nodes of which codegen expects exactly one child
+    void requireOne(std::initializer_list<const ASTNode *> children);
+
+    // counts the statements, blocks and expressions being read, so that a crafted file
+    // can't nest them until the stack overflows
+    class NestingScope {
+    public:
+        explicit NestingScope(ASTReader &reader): _reader(reader) {
+            if (++_reader._depth > MaxDepth) {
+                _reader.error("nesting too deep");
+            }
+        }
+        ~NestingScope() { --_reader._depth; }
+
+    private:
+        ASTReader &_reader;
+    };
+
+    ProgNode *readProg();
+    ItemNode *readItem();
+    ExternDeclNode *readExternDecl();
+    FuncNode *readFunc();
+    FuncFParamsNode *readFuncFParams();
+    FuncFParamNode *readFuncFParam();
+    BlockNode *readBlock();
+    BlockItemNode *readBlockItem();
+    DeclNode *readDecl();
+    ConstDeclNode *readConstDecl();
+    VarDeclNode *readVarDecl();
+    ConstDefNode *readConstDef();
+    VarDefNode *readVarDef();
+    InitValNode *readInitVal();
+    StmtNode *readStmt();
+    ExprNode *readExpr();
+
+    llvm::StringRef _data;
+    size_t _pos = 0;
+    ASTArena &_arena;
+    // the Symbols of the names in the file, in the arena
+    std::vector<Symbol> _symbols;
+    unsigned _depth = 0;
+    std::string _error;
+};
+
+void ASTReader::error(const std::string &msg) {
+    _error = msg + " at offset " + std::to_string(_pos);
+    throw FormatError{};
+}
+
+uint8_t ASTReader::readByte() {
+    if (_pos >= _data.size()) {
+        error("unexpected end of file");
+    }
+    return static_cast<uint8_t>(_data[_pos++]);
+}
+
+uint64_t ASTReader::readUInt() {
+    unsigned length;
+    const char *err = nullptr;
+    auto begin = reinterpret_cast<const uint8_t *>(_data.data());
+    uint64_t value = llvm::decodeULEB128(begin + _pos, &length, begin + _data.size(), &err);
+    if (err != nullptr) {
+        error(err);
+    }
+    _pos += length;
+    return value;
+}
+
+int64_t ASTReader::readInt() {
+    unsigned length;
+    const char *err = nullptr;
+    auto begin = reinterpret_cast<const uint8_t *>(_data.data());
+    int64_t value = llvm::decodeSLEB128(begin + _pos, &length, begin + _data.size(), &err);
+    if (err != nullptr) {
+        error(err);
+    }
+    _pos += length;
+    return value;
+}
+
+llvm::StringRef ASTReader::readString() {
+    uint64_t size = readUInt();
+    if (size > _data.size() - _pos) {
+        error("string out of bounds");
+    }
+    auto str = _data.substr(_pos, size);
+    _pos += size;
+    return str;
+}
+
+Symbol ASTReader::readSymbol() {
+    uint64_t index = readUInt();
+    if (index == 0) {
+        return NoSymbol;
+    }
+    if (index > _symbols.size()) {
+        error("invalid symbol " + std::to_string(index - 1));
+    }
+    return _symbols[index - 1];
+}
+
+Symbol ASTReader::readRequiredSymbol() {
+    Symbol symbol = readSymbol();
+    if (symbol == NoSymbol) {
+        error("missing identifier");
+    }
+    return symbol;
+}
+
+void ASTReader::requireOne(std::initializer_list<const ASTNode *> children) {
+    unsigned count = 0;
+    for (auto child : children) {
+        count += child != nullptr;
+    }
+    if (count != 1) {
+        error("expected exactly one child, got " + std::to_string(count));
+    }
+}
+
+size_t ASTReader::readCount() {
+    uint64_t count = readUInt();
+    if (count > _data.size() - _pos) {
+        error("list out of bounds");
+    }
+    return count;
+}
+
+bool ASTReader::begin(NodeKind kind) {
+    auto actual = static_cast<NodeKind>(readByte());
+    if (actual == NodeKind::Null) {
+        return false;
+    }
+    if (actual != kind) {
+        --_pos;
+        error("unexpected node kind " + std::to_string(static_cast<unsigned>(actual)));
+    }
+    return true;
+}
+
+EntryNode *ASTReader::readEntry() {
+    try {
+        if (!_data.starts_with(llvm::StringRef(Magic, sizeof(Magic)))) {
+            error("not an l24 AST file");
+        }
+        _pos = sizeof(Magic);
+        if (readByte() != Version) {
+            error("unsupported AST file version");
+        }
+        size_t symbols = readCount();
+        _symbols.reserve(symbols);
+        for (size_t i = 0; i < symbols; ++i) {
+            _symbols.push_back(_arena.intern(readString()));
+        }
+        auto entry = _arena.create<EntryNode>();
+        entry->_prog = required(readProg());
+        entry->_symbols = &_arena.symbols();
+        if (_pos != _data.size()) {
+            error("trailing bytes");
+        }
+        return entry;
+    } catch (FormatError &) {
+        return nullptr;
+    }
+}
+
+ProgNode *ASTReader::readProg() {
+    if (!begin(NodeKind::Prog)) {
+        return nullptr;
+    }
+    auto prog = _arena.create<ProgNode>();
+    std::vector<ASTNode *> items(readCount());
+    for (auto &item : items) {
+        item = required(readItem());
+    }
+    prog->_items = _arena.copyList(items);
+    return prog;
+}
+
+ItemNode *ASTReader::readItem() {
+    if (!begin(NodeKind::Item)) {
+        return nullptr;
+    }
+    auto item = _arena.create<ItemNode>();
+    item->_decl = readDecl();
+    item->_func = readFunc();
+    item->_extern_decl = readExternDecl();
+    requireOne({item->_decl, item->_func, item->_extern_decl});
+    return item;
+}
+
+ExternDeclNode *ASTReader::readExternDecl() {
+    if (!begin(NodeKind::ExternDecl)) {
+        return nullptr;
+    }
+    auto extern_decl = _arena.create<ExternDeclNode>();
+    uint8_t flags = readByte();
+    extern_decl->_is_func = flags & IsFunc;
+    extern_decl->_is_array = flags & IsArray;
+    extern_decl->_type = _arena.copyString(readString());
+    extern_decl->_ident = readRequiredSymbol();
+    extern_decl->_param = readFuncFParams();
+    extern_decl->_exp = readExpr();
+    if (extern_decl->_is_func) {
+        required(extern_decl->_param);
+    }
+    return extern_decl;
+}
+
+FuncNode *ASTReader::readFunc() {
+    if (!begin(NodeKind::Func)) {
+        return nullptr;
+    }
+    auto func = _arena.create<FuncNode>();
+    func->_type = _arena.copyString(readString());
+    func->_ident = readRequiredSymbol();
+    func->_param = required(readFuncFParams());
+    func->_block = required(readBlock());
+    return func;
+}
+
+FuncFParamsNode *ASTReader::readFuncFParams() {
+    if (!begin(NodeKind::FuncFParams)) {
+        return nullptr;
+    }
+    auto params = _arena.create<FuncFParamsNode>();
+    std::vector<ASTNode *> param_list(readCount());
+    for (auto &param : param_list) {
+        param = required(readFuncFParam());
+    }
+    params->_params = _arena.copyList(param_list);
+    return params;
+}
+
+FuncFParamNode *ASTReader::readFuncFParam() {
+    if (!begin(NodeKind::FuncFParam)) {
+        return nullptr;
+    }
+    auto param = _arena.create<FuncFParamNode>();
+    param->_type = _arena.copyString(readString());
+    param->_ident = readRequiredSymbol();
+    return param;
+}
+
+BlockNode *ASTReader::readBlock() {
+    if (!begin(NodeKind::Block)) {
+        return nullptr;
+    }
+    NestingScope scope(*this);
+    auto block = _arena.create<BlockNode>();
+    std::vector<ASTNode *> block_items(readCount());
+    for (auto &block_item : block_items) {
+        block_item = required(readBlockItem());
+    }
+    block->_block_items = _arena.copyList(block_items);
+    return block;
+}
+
+BlockItemNode *ASTReader::readBlockItem() {
+    if (!begin(NodeKind::BlockItem)) {
+        return nullptr;
+    }
+    auto block_item = _arena.create<BlockItemNode>();
+    block_item->_decl = readDecl();
+    block_item->_stmt = readStmt();
+    requireOne({block_item->_decl, block_item->_stmt});
+    return block_item;
+}
+
+DeclNode *ASTReader::readDecl() {
+    if (!begin(NodeKind::Decl)) {
+        return nullptr;
+    }
+    auto decl = _arena.create<DeclNode>();
+    decl->_const_decl = readConstDecl();
+    decl->_var_decl = readVarDecl();
+    requireOne({decl->_const_decl, decl->_var_decl});
+    return decl;
+}
+
+ConstDeclNode *ASTReader::readConstDecl() {
+    if (!begin(NodeKind::ConstDecl)) {
+        return nullptr;
+    }
+    auto const_decl = _arena.create<ConstDeclNode>();
+    const_decl->_b_type = _arena.copyString(readString());
+    std::vector<ASTNode *> const_defs(readCount());
+    for (auto &const_def : const_defs) {
+        const_def = required(readConstDef());
+    }
+    const_decl->_const_defs = _arena.copyList(const_defs);
+    return const_decl;
+}
+
+VarDeclNode *ASTReader::readVarDecl() {
+    if (!begin(NodeKind::VarDecl)) {
+        return nullptr;
+    }
+    auto var_decl = _arena.create<VarDeclNode>();
+    var_decl->_b_type = _arena.copyString(readString());
+    std::vector<ASTNode *> var_defs(readCount());
+    for (auto &var_def : var_defs) {
+        var_def = required(readVarDef());
+    }
+    var_decl->_var_defs = _arena.copyList(var_defs);
+    return var_decl;
+}
+
+ConstDefNode *ASTReader::readConstDef() {
+    if (!begin(NodeKind::ConstDef)) {
+        return nullptr;
+    }
+    auto const_def = _arena.create<ConstDefNode>();
+    const_def->_ident = readRequiredSymbol();
+    const_def->_init_val = required(readInitVal());
+    const_def->_exp = readExpr();
+    return const_def;
+}
+
+VarDefNode *ASTReader::readVarDef() {
+    if (!begin(NodeKind::VarDef)) {
+        return nullptr;
+    }
+    auto var_def = _arena.create<VarDefNode>();
+    var_def->_ident = readRequiredSymbol();
+    var_def->_init_val = readInitVal();
+    var_def->_exp = readExpr();
+    return var_def;
+}
+
+InitValNode *ASTReader::readInitVal() {
+    if (!begin(NodeKind::InitVal)) {
+        return nullptr;
+    }
+    auto init_val = _arena.create<InitValNode>();
+    init_val->_is_array = readByte() != 0;
+    init_val->_string_literal = _arena.copyString(readString());
+    std::vector<ASTNode *> exps(readCount());
+    for (auto &exp : exps) {
+        exp = required(readExpr());
+    }
+    init_val->_exp = _arena.copyList(exps);
+    return init_val;
+}
+
+StmtNode *ASTReader::readStmt() {
+    if (!begin(NodeKind::Stmt)) {
+        return nullptr;
+    }
+    NestingScope scope(*this);
+    auto stmt = _arena.create<StmtNode>();
+    uint8_t flags = readByte();
+    stmt->_is_ret_stmt = flags & IsReturn;
+    stmt->_is_continue_stmt = flags & IsContinue;
+    stmt->_is_break_stmt = flags & IsBreak;
+    stmt->_l_val = readSymbol();
+    stmt->_sub_idx = readExpr();
+    stmt->_expr = readExpr();
+    stmt->_block = readBlock();
+    stmt->_if_stmt = readStmt();
+    stmt->_else_stmt = readStmt();
+    stmt->_while_stmt = readStmt();
+
+    // the fields codegen reads, see CodeGenBase::codeGenStmt
+    bool compound = stmt->_block != nullptr || stmt->_if_stmt != nullptr ||
+                    stmt->_while_stmt != nullptr;
+    if ((stmt->_if_stmt != nullptr || stmt->_while_stmt != nullptr ||
+         stmt->_l_val != NoSymbol) && stmt->_expr == nullptr) {
+        error("missing expression of statement");
+    }
+    if (stmt->_else_stmt != nullptr && stmt->_if_stmt == nullptr) {
+        error("else without if");
+    }
+    if (stmt->_sub_idx != nullptr && stmt->_l_val == NoSymbol) {
+        error("index without assignment");
+    }
+    if (stmt->_l_val != NoSymbol && (compound || flags != 0)) {
+        error("assignment in a compound, return, break or continue statement");
+    }
+    return stmt;
+}
+
+ExprNode *ASTReader::readExpr() {
+    NestingScope scope(*this);
+    auto kind = static_cast<NodeKind>(readByte());
+    switch (kind) {
+    case NodeKind::Null:
+        return nullptr;
+    case NodeKind::Binary: {
+        // the parsers build a left-associative chain a + b + c as nested left operands,
+        // which a long generated expression makes deeper than MaxDepth. the operators of
+        // the chain are read in a loop, and only its right operands recurse
+        std::vector<BinaryOp> ops;
+        while (true) {
+            uint8_t op = readByte();
+            if (op > static_cast<uint8_t>(BinaryOp::Rem)) {
+                error("invalid binary operator " + std::to_string(op));
+            }
+            ops.push_back(static_cast<BinaryOp>(op));
+            if (_pos >= _data.size() || _data[_pos] != static_cast<char>(NodeKind::Binary)) {
+                break;
+            }
+            ++_pos;
+        }
+        ExprNode *lhs = required(readExpr());
+        for (auto op = ops.rbegin(); op != ops.rend(); ++op) {
+            lhs = _arena.create<BinaryExprNode>(*op, lhs, required(readExpr()));
+        }
+        return lhs;
+    }
+    case NodeKind::Unary: {
+        uint8_t op = readByte();
+        if (op > static_cast<uint8_t>(UnaryOp::Not)) {
+            error("invalid unary operator " + std::to_string(op));
+        }
+        return _arena.create<UnaryExprNode>(static_cast<UnaryOp>(op), required(readExpr()));
+    }
+    case NodeKind::Literal:
+        return _arena.create<LiteralNode>(readInt());
+    case NodeKind::VarRef: {
+        auto var_ref = _arena.create<VarRefNode>();
+        var_ref->_ident = readRequiredSymbol();
+        var_ref->_exp = readExpr();
+        return var_ref;
+    }
+    case NodeKind::Call: {
+        auto call = _arena.create<CallNode>();
+        call->_func_ident = readRequiredSymbol();
+        std::vector<ExprNode *> args(readCount());
+        for (auto &arg : args) {
+            arg = required(readExpr());
+        }
+        call->_args = _arena.copyList(args);
+        return call;
+    }
+    default:
+        --_pos;
+        error("unexpected node kind " + std::to_string(static_cast<unsigned>(kind)));
+    }
+}
+} // namespace
+
+void writeAST(const EntryNode &entry, llvm::raw_ostream &os) {
+    ASTWriter(*entry._symbols).writeEntry(entry, os);
+}
+
+EntryNode *readAST(llvm::MemoryBufferRef buffer, ASTArena &arena, std::string &error) {
+    ASTReader reader(buffer.getBuffer(), arena);
+    EntryNode *entry = reader.readEntry();
+    if (entry == nullptr) {
+        error = reader.error();
+    }
+    return entry;
+}
+
+} // namespace l24
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "frontend/ast.h"
+#include "frontend/ast_arena.h"
+
+namespace l24 {
+
+// Binary AST files of --dump-ast/--load-ast, which skip lexing and parsing of sources
+// that didn't change.
+// A file is the magic "L24AST" and a version byte, the names used by the AST, then the
+// nodes in preorder: every node starts with its kind (0 for a null child) followed by
+// its fields and children, lists are prefixed with their length. Integers are LEB128
+// encoded and identifiers are indices into the names, which are numbered by their first
+// use so that the file doesn't depend on the order the Symbols were interned in.
+void writeAST(const EntryNode &entry, llvm::raw_ostream &os);
+
+// Rebuild the AST of a file written by writeAST in arena. Returns nullptr and sets error
+// if buffer is not an AST file of this version. Names and strings are copied into the
+// arena, so buffer (usually a mapped file) only has to live until this returns.
+EntryNode *readAST(llvm::MemoryBufferRef buffer, ASTArena &arena, std::string &error);
+
+} // namespace l24
@@ -1,58 +1,294 @@
+#include <algorithm>
 #include <iostream>
-#include <istream>
 #include <memory>
 
 
 #include "l24Lexer.h"
 #include "l24Parser.h"
 #include "antlr4-runtime.h"
+#include "atn/ParseInfo.h"
+#include "atn/ProfilingATNSimulator.h"
 
-#include "llvm/Support/Debug.h"
-#include "llvm/Support/FileSystem.h"
-
+#include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 
 #include "frontend/ast.h"
 #include "frontend/ast_builder.h"
 #include "frontend/front_end.h"
+#include "frontend/native_lexer.h"
+#include "frontend/native_parser.h"
+#include "frontend/source_stream.h"
+#include "support/phase_timer.h"
 
 using namespace antlr4;
 
+namespace l24 {
 
-#define DEBUG_TYPE "l24-FrontEnd"
+namespace {
+// smallest chunk of a source that is parsed on its own thread
+constexpr size_t MinChunkSize = 64 * 1024;
 
-namespace l24 {
+// collect syntax errors instead of printing them to std::cerr like ConsoleErrorListener,
+// so that concurrent compilations report them per file
+class SyntaxErrorCollector : public BaseErrorListener {
+public:
+    explicit SyntaxErrorCollector(std::vector<std::string> &errors): _errors(errors) {}
+
+    void syntaxError(Recognizer *recognizer, Token *offendingSymbol, size_t line,
+                     size_t charPositionInLine, const std::string &msg,
+                     std::exception_ptr e) override {
+        _errors.push_back(std::to_string(line) + ":" + std::to_string(charPositionInLine) +
+                          ": " + msg);
+    }
+
+private:
+    std::vector<std::string> &_errors;
+};
+
+// l24Parser that frees the parse tree after every top-level item
+class ItemParser : public l24Parser {
+public:
+    using l24Parser::l24Parser;
+
+    // delete every context and terminal node created so far
+    void releaseParseTree() { _tracker.reset(); }
+};
+
+// the lexer selected by the FrontEndOptions, lexical errors are reported to listener.
+// input starts at the beginning of line
+std::unique_ptr<TokenSource> createLexer(LexerKind kind, SourceStream &input, ANTLRErrorListener &listener,
+                                         size_t line = 1) {
+    if (kind == LexerKind::Native) {
+        return std::make_unique<NativeTokenSource>(input, listener, line);
+    }
+    auto lexer = std::make_unique<l24Lexer>(&input);
+    lexer->setLine(line);
+    lexer->removeErrorListeners();
+    lexer->addErrorListener(&listener);
+    return lexer;
+}
+} // namespace
 
-std::shared_ptr<ASTNode> FrontEnd::parse(std::istream& stream) {
-    llvm::DebugFlag = true;
-
-    ANTLRInputStream Input(stream);
-    l24Lexer Lexer(&Input);
-    CommonTokenStream Tokens(&Lexer);
-    Tokens.fill();
-    LLVM_DEBUG({
-        llvm::outs() << "===== Lexer ===== \n";
-        for (auto token : Tokens.getTokens()) {
-            llvm::outs() << token->toString() << "\n";
+void FrontEnd::dumpTokens(llvm::MemoryBufferRef source) const {
+    // a separate pass over the source, the parser never holds all the tokens.
+    // lexical errors are reported by the lexer of the parser
+    BaseErrorListener ignore_errors;
+    SourceStream input(source);
+    auto lexer = createLexer(_opts._lexer, input, ignore_errors);
+    CommonTokenStream tokens(lexer.get());
+    tokens.fill();
+    *_dump_os << "===== Lexer ===== \n";
+    for (auto token : tokens.getTokens()) {
+        *_dump_os << token->toString() << "\n";
+    }
+    *_dump_os << "===== Lexer End ===== \n";
+}
+
+void FrontEnd::dumpParseStats(l24Parser &parser, size_t items, size_t ll_items) const {
+    auto *profiler = dynamic_cast<atn::ProfilingATNSimulator *>(parser.getInterpreter<atn::ParserATNSimulator>());
+    if (profiler == nullptr) {
+        return;
+    }
+    atn::ParseInfo info(profiler);
+    const auto &rule_names = parser.getRuleNames();
+    const auto &atn = parser.getATN();
+
+    auto &os = *_dump_os;
+    os << "===== Parse Stats ===== \n";
+    os << "stage: " << items << " items, " << ll_items << " parsed again with LL after SLL failed\n";
+    os << "decision  rule               invocations  SLL-look  SLL-max  LL-fallback  LL-look  LL-max  ambiguities  max-ambig-depth  DFA-states\n";
+    for (const auto &decision : info.getDecisionInfo()) {
+        if (decision.invocations == 0) {
+            continue;
+        }
+        size_t max_ambiguity = 0;
+        for (const auto &ambiguity : decision.ambiguities) {
+            max_ambiguity = std::max(max_ambiguity, ambiguity.stopIndex - ambiguity.startIndex + 1);
+        }
+        auto rule = rule_names[atn.decisionToState[decision.decision]->ruleIndex];
+        os << llvm::format("%8zu  %-18s %11lld  %8lld  %7lld  %11lld  %7lld  %6lld  %11zu  %15zu  %10zu\n",
+                           decision.decision, rule.c_str(), decision.invocations,
+                           decision.SLL_TotalLook, decision.SLL_MaxLook, decision.LL_Fallback,
+                           decision.LL_TotalLook, decision.LL_MaxLook, decision.ambiguities.size(),
+                           max_ambiguity, info.getDFASize(decision.decision));
+    }
+    os << "total: " << info.getTotalSLLLookaheadOps() << " SLL and " << info.getTotalLLLookaheadOps()
+       << " LL lookahead ops, " << info.getLLDecisions().size() << " decisions needed LL, "
+       << info.getDFASize() << " DFA states, " << info.getTotalTimeInPrediction() / 1000 << " us in prediction\n";
+    os << "===== Parse Stats End ===== \n";
+}
+
+void FrontEnd::dumpASTStats(const ASTArena &arena) const {
+    *_dump_os << "ast: " << arena.nodes() << " nodes, " << arena.bytes() << " bytes in "
+              << arena.slabs() << " slabs, "
+              << arena.symbols().size() << " symbols\n";
+}
+
+EntryNode *FrontEnd::parse(llvm::MemoryBufferRef source, ASTArena &arena) {
+    _errors.clear();
+    unsigned threads = llvm::hardware_concurrency(_opts._parse_threads).compute_thread_count();
+    // the dumps describe one serial parse
+    bool dumps = _dump_os != nullptr && (_dump_tokens || _dump_parse_tree || _dump_parse_stats);
+    std::vector<SourceChunk> chunks;
+    if (threads > 1 && !dumps) {
+        // a few chunks per thread to even out the load, but not so small that the
+        // setup of each parser costs more than parsing it
+        size_t chunk_size = std::max<size_t>(source.getBufferSize() / (threads * 4), MinChunkSize);
+        chunks = splitSource(source.getBuffer(), chunk_size);
+    }
+
+    ProgNode *program;
+    if (chunks.size() > 1) {
+        program = parseChunks(source, chunks, threads, arena);
+    } else {
+        program = parseItems(source, 1, arena, _errors, true);
+    }
+    if (program == nullptr) {
+        return nullptr;
+    }
+
+    EntryNode *ast = ASTBuilder::buildEntry(arena, program);
+    if (_dump_os != nullptr && _dump_parse_stats) {
+        dumpASTStats(arena);
+    }
+    return ast;
+}
+
+ProgNode *FrontEnd::parseItems(llvm::MemoryBufferRef source, size_t line, ASTArena &arena,
+                               std::vector<std::string> &errors, bool whole_source) const {
+    if (_opts._parser == ParserKind::ANTLR) {
+        return parseWithANTLR(source, line, arena, errors, whole_source);
+    }
+    // lexing, parsing and AST building are one pass
+    PhaseTimer timer("parse", "Parsing", whole_source);
+    return NativeParser(source.getBuffer(), arena, errors, line).parse();
+}
+
+ProgNode *FrontEnd::parseChunks(llvm::MemoryBufferRef source, llvm::ArrayRef<SourceChunk> chunks,
+                                unsigned threads, ASTArena &arena) {
+    PhaseTimer timer("parse", "Parsing");
+    // every chunk allocates in its own arena, created before any thread runs
+    std::vector<std::unique_ptr<ASTArena>> arenas;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        arenas.push_back(std::make_unique<ASTArena>(arena));
+    }
+    std::vector<ProgNode *> programs(chunks.size());
+    std::vector<std::vector<std::string>> errors(chunks.size());
+    {
+        llvm::ThreadPool pool(llvm::hardware_concurrency(threads));
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            pool.async([&, i] {
+                const SourceChunk &chunk = chunks[i];
+                llvm::MemoryBufferRef buffer(source.getBuffer().slice(chunk._begin, chunk._end),
+                                             source.getBufferIdentifier());
+                programs[i] = parseItems(buffer, chunk._line, *arenas[i], errors[i], false);
+            });
+        }
+        pool.wait();
+    }
+
+    for (const auto &chunk_errors : errors) {
+        if (!chunk_errors.empty()) {
+            // error recovery depends on what comes before, parse the whole source again
+            // so that the errors are the same as without threads
+            return parseItems(source, 1, arena, _errors, false);
+        }
+    }
+
+    // the items of the chunks in source order, the nodes stay in the chunk arenas
+    std::vector<ASTNode *> items;
+    for (ProgNode *program : programs) {
+        items.insert(items.end(), program->_items.begin(), program->_items.end());
+    }
+    for (auto &chunk_arena : arenas) {
+        arena.adopt(std::move(chunk_arena));
+    }
+    return ASTBuilder::buildProgram(arena, items);
+}
+
+ProgNode *FrontEnd::parseWithANTLR(llvm::MemoryBufferRef source, size_t line, ASTArena &arena,
+                                   std::vector<std::string> &errors, bool whole_source) const {
+    if (_dump_os != nullptr && _dump_tokens) {
+        dumpTokens(source);
+    }
+
+    SyntaxErrorCollector errorListener(errors);
+    SourceStream Input(source);
+    auto Lexer = createLexer(_opts._lexer, Input, errorListener, line);
+    // tokens are pulled from the lexer while parsing, and only those of the item being
+    // parsed are buffered
+    UnbufferedTokenStream Tokens(Lexer.get());
+    ItemParser Parser(&Tokens);
+    bool profile = _dump_os != nullptr && _dump_parse_stats;
+    if (profile) {
+        Parser.setProfile(true);
+    }
+    auto *simulator = Parser.getInterpreter<atn::ParserATNSimulator>();
+    auto bail = std::make_shared<BailErrorStrategy>();
+    Parser.removeErrorListeners();
+    Parser.setErrorHandler(bail);
+    simulator->setPredictionMode(atn::PredictionMode::SLL);
+
+    ASTBuilder builder(arena, errorListener);
+    std::vector<ASTNode *> item_nodes;
+    size_t items = 0;
+    size_t ll_items = 0;
+    std::string parse_tree;
+    do {
+        // the tokens of the item stay buffered for the LL stage and the AST builder
+        ssize_t marker = Tokens.mark();
+        size_t start = Tokens.index();
+        l24Parser::ItemContext *item;
+        {
+            PhaseTimer timer("parse", "Parsing", whole_source);
+            // two-stage parsing: SLL prediction is much cheaper than full LL and gives the
+            // same tree for every input it accepts. it may reject valid input though, so the
+            // first stage bails out silently on any error and the item is parsed again with
+            // full LL, which also reports the real syntax errors
+            try {
+                item = Parser.item();
+            } catch (ParseCancellationException &) {
+                ++ll_items;
+                Tokens.seek(start);
+                Parser.addErrorListener(&errorListener);
+                Parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+                simulator->setPredictionMode(atn::PredictionMode::LL);
+                item = Parser.item();
+                Parser.removeErrorListeners();
+                Parser.setErrorHandler(bail);
+                simulator->setPredictionMode(atn::PredictionMode::SLL);
+            }
+        }
+        ++items;
+        // after a syntax error the rest of the input is only parsed for more errors
+        if (errors.empty()) {
+            if (_dump_os != nullptr && _dump_parse_tree) {
+                parse_tree += item->toStringTree(&Parser, true) + "\n";
+            }
+            PhaseTimer timer("build-ast", "AST Building", whole_source);
+            item_nodes.push_back(builder.buildItem(item));
         }
-        llvm::outs() << "===== Lexer End ===== \n";
-    });
-
-    ANTLRErrorListener *errorListener = new BaseErrorListener();
-    l24Parser Parser(&Tokens);
-    Parser.addErrorListener(errorListener);
-    l24Parser::EntryContext* entry = Parser.entry();
-    LLVM_DEBUG({
-        llvm::outs() << "===== Parser ===== \n";
-        llvm::outs() << entry->toStringTree(&Parser, true) << "\n";
-        if (Parser.getNumberOfSyntaxErrors()) {
-            llvm::errs() << "===== Parser Failed ===== \n";
-            return nullptr;
+        // error recovery may consume nothing
+        if (Tokens.index() == start && Tokens.LA(1) != Token::EOF) {
+            Tokens.consume();
         }
-        llvm::outs() << "===== Parser End ===== \n";
-    });
+        Parser.releaseParseTree();
+        Tokens.release(marker);
+    } while (Tokens.LA(1) != Token::EOF);
 
-    ASTBuilder builder;
-    return builder.build(entry);
+    if (profile) {
+        dumpParseStats(Parser, items, ll_items);
+    }
+    if (!errors.empty()) {
+        return nullptr;
+    }
+    if (_dump_os != nullptr && _dump_parse_tree) {
+        *_dump_os << "===== Parser ===== \n";
+        *_dump_os << parse_tree;
+        *_dump_os << "===== Parser End ===== \n";
+    }
+    return ASTBuilder::buildProgram(arena, item_nodes);
 }
 
 }  // namespace l24
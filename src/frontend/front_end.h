@@ -1,17 +1,67 @@
 #pragma once
 
-#include <istream>
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "frontend/ast.h"
+#include "frontend/ast_arena.h"
+#include "frontend/front_end_opts.h"
+#include "frontend/source_splitter.h"
+
+class l24Parser;
 
 namespace l24 {
 
 class FrontEnd {
 
 public:
-    // Parse an input stream and return an AST.
-    std::shared_ptr<ASTNode> parse(std::istream& Stream);
+    FrontEnd() = default;
+    explicit FrontEnd(const FrontEndOptions &opts): _opts(opts) {}
+
+    // Parse a source buffer and return an AST allocated in arena, nullptr if there are
+    // syntax errors. The lexer reads the buffer in place, pass a memory-mapped file to
+    // avoid copying it. With more than one parse thread, a large source is split into
+    // chunks of top-level items that are parsed concurrently.
+    EntryNode *parse(llvm::MemoryBufferRef source, ASTArena &arena);
+
+    // syntax errors ("line:col: message") found by the last parse
+    const std::vector<std::string> &errors() const { return _errors; }
+
+    // write the token stream, parse tree and/or ATN prediction statistics of every parse
+    // into os, for debugging the grammar. nothing is dumped by default, the native parser
+    // has no tokens, parse tree or ATN to dump and only prints the AST statistics
+    void enableDumps(llvm::raw_ostream &os, bool tokens, bool parse_tree, bool parse_stats) {
+        _dump_os = &os;
+        _dump_tokens = tokens;
+        _dump_parse_tree = parse_tree;
+        _dump_parse_stats = parse_stats;
+    }
+
+private:
+    // the items of source, which starts at the beginning of line, nullptr if there are
+    // syntax errors. phase timers and dumps are only enabled for a whole_source
+    ProgNode *parseItems(llvm::MemoryBufferRef source, size_t line, ASTArena &arena,
+                         std::vector<std::string> &errors, bool whole_source) const;
+    ProgNode *parseWithANTLR(llvm::MemoryBufferRef source, size_t line, ASTArena &arena,
+                             std::vector<std::string> &errors, bool whole_source) const;
+    // parse the chunks on threads and link their items in source order
+    ProgNode *parseChunks(llvm::MemoryBufferRef source, llvm::ArrayRef<SourceChunk> chunks,
+                          unsigned threads, ASTArena &arena);
+    void dumpTokens(llvm::MemoryBufferRef source) const;
+    void dumpParseStats(l24Parser &parser, size_t items, size_t ll_items) const;
+    void dumpASTStats(const ASTArena &arena) const;
+
+    FrontEndOptions _opts;
+    std::vector<std::string> _errors;
+    llvm::raw_ostream *_dump_os = nullptr;
+    bool _dump_tokens = false;
+    bool _dump_parse_tree = false;
+    bool _dump_parse_stats = false;
 };
 
 }  // namespace l24
\ No newline at end of file
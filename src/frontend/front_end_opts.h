@@ -0,0 +1,32 @@
+#pragma once
+
+namespace l24 {
+
+// which lexer produces the tokens for the parser
+enum class LexerKind {
+    // generated from grammar/l24.g4 by ANTLR
+    ANTLR,
+    // hand-written NativeLexer, same token stream
+    Native,
+};
+
+// what builds the AST
+enum class ParserKind {
+    // l24Parser generated by ANTLR, then ASTBuilder on its parse tree
+    ANTLR,
+    // hand-written NativeParser, builds the AST directly from the tokens of NativeLexer
+    Native,
+};
+
+// options that control how the front end parses a source file,
+// they don't change the AST, only how fast it is built
+struct FrontEndOptions {
+    // only used by the ANTLR parser
+    LexerKind _lexer = LexerKind::ANTLR;
+    ParserKind _parser = ParserKind::ANTLR;
+    // threads that parse the top-level items of one source concurrently, 0 = one per
+    // hardware thread. sources are only split when they are large enough
+    unsigned _parse_threads = 1;
+};
+
+} // namespace l24
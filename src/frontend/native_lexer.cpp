@@ -0,0 +1,256 @@
+#include <algorithm>
+
+#include "l24Lexer.h"
+
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/ADT/bit.h"
+
+#include "frontend/native_lexer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace antlr4;
+
+namespace l24 {
+
+namespace {
+// first position in [pos, end) that is neither ' ' nor '\t', end if there is none
+size_t skipBlanks(llvm::StringRef data, size_t pos, size_t end) {
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + pos));
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab));
+        unsigned others = ~static_cast<unsigned>(_mm_movemask_epi8(blank)) & 0xffff;
+        if (others != 0) {
+            return pos + llvm::countr_zero(others);
+        }
+    }
+#endif
+    while (pos < end && (data[pos] == ' ' || data[pos] == '\t')) {
+        ++pos;
+    }
+    return pos;
+}
+
+// first position in [pos, end) that is a or b, end if there is none
+size_t findEither(llvm::StringRef data, size_t pos, size_t end, char a, char b) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + pos));
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+        unsigned found = static_cast<unsigned>(_mm_movemask_epi8(match));
+        if (found != 0) {
+            return pos + llvm::countr_zero(found);
+        }
+    }
+#endif
+    while (pos < end && data[pos] != a && data[pos] != b) {
+        ++pos;
+    }
+    return pos;
+}
+
+bool isIdentStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// same as Lexer::getErrorDisplay
+std::string errorDisplay(llvm::StringRef text) {
+    std::string display;
+    for (char c : text) {
+        switch (c) {
+        case '\n': display += "\\n"; break;
+        case '\t': display += "\\t"; break;
+        case '\r': display += "\\r"; break;
+        default: display += c; break;
+        }
+    }
+    return display;
+}
+} // namespace
+
+void NativeLexer::advanceTo(size_t end) {
+    for (size_t p = findEither(_data, _pos, end, '\n', '\n'); p < end;
+         p = findEither(_data, p + 1, end, '\n', '\n')) {
+        ++_line;
+        _line_start = p + 1;
+    }
+    _pos = end;
+}
+
+void NativeLexer::reportError(size_t start, size_t end, size_t line, size_t column) {
+    _on_error(line, column, "token recognition error at: '" + errorDisplay(_data.slice(start, end)) + "'");
+}
+
+NativeToken NativeLexer::lex() {
+    const size_t size = _data.size();
+    for (;;) {
+        size_t start = _pos;
+        size_t line = _line;
+        size_t column = _pos - _line_start;
+        // the token ends at _pos
+        auto makeToken = [&](size_t type) {
+            NativeToken token;
+            token._type = type;
+            token._start = start;
+            token._end = _pos;
+            token._line = line;
+            token._column = column;
+            return token;
+        };
+        if (_pos >= size) {
+            return makeToken(Token::EOF);
+        }
+
+        // skipped tokens, comments and operators
+        size_t type = Token::INVALID_TYPE;
+        size_t length = 1;
+        char c = _data[_pos];
+        char next = _pos + 1 < size ? _data[_pos + 1] : '\0';
+        switch (c) {
+        case ' ':
+        case '\t':
+            // Whitespace
+            _pos = skipBlanks(_data, _pos + 1, size);
+            continue;
+        case '\n':
+        case '\r':
+            // Newline
+            advanceTo(_pos + (c == '\r' && next == '\n' ? 2 : 1));
+            continue;
+        case '/':
+            if (next == '/') {
+                // LINECOMMENT, the newline is a token of its own
+                _pos = findEither(_data, _pos + 2, size, '\r', '\n');
+                continue;
+            }
+            if (next == '*') {
+                // BlockComments, without "*/" the input is lexed as '/' '*' ...
+                size_t star = findEither(_data, _pos + 2, size, '*', '*');
+                while (star + 1 < size && _data[star + 1] != '/') {
+                    star = findEither(_data, star + 1, size, '*', '*');
+                }
+                if (star + 1 < size) {
+                    advanceTo(star + 2);
+                    continue;
+                }
+            }
+            type = l24Lexer::Slash;
+            break;
+        case '"': {
+            size_t quote = findEither(_data, _pos + 1, size, '"', '"');
+            if (quote == size) {
+                // unterminated, l24Lexer gives up at EOF
+                reportError(start, size, line, column);
+                advanceTo(size);
+                continue;
+            }
+            advanceTo(quote + 1);
+            return makeToken(l24Lexer::StringLiteral);
+        }
+        case '<':
+            type = next == '=' ? l24Lexer::LessEq : l24Lexer::Less;
+            length = next == '=' ? 2 : 1;
+            break;
+        case '>':
+            type = next == '=' ? l24Lexer::GreaterEq : l24Lexer::Greater;
+            length = next == '=' ? 2 : 1;
+            break;
+        case '!':
+            type = next == '=' ? l24Lexer::NotEq : l24Lexer::Not;
+            length = next == '=' ? 2 : 1;
+            break;
+        case '=':
+            type = next == '=' ? l24Lexer::Eq : l24Lexer::Assign;
+            length = next == '=' ? 2 : 1;
+            break;
+        case '&':
+        case '|':
+            if (next == c) {
+                type = c == '&' ? l24Lexer::LogicalAnd : l24Lexer::LogicalOr;
+                length = 2;
+                break;
+            }
+            // l24Lexer has already consumed the next byte when it fails, reports it
+            // and skips it
+            reportError(start, std::min(_pos + 2, size), line, column);
+            advanceTo(std::min(_pos + 2, size));
+            continue;
+        case '*': type = l24Lexer::Star; break;
+        case '%': type = l24Lexer::Percentage; break;
+        case '+': type = l24Lexer::Plus; break;
+        case '-': type = l24Lexer::Minus; break;
+        case ';': type = l24Lexer::SemiColon; break;
+        case ',': type = l24Lexer::Comm; break;
+        case '{': type = l24Lexer::LeftBrace; break;
+        case '}': type = l24Lexer::RightBrace; break;
+        case '(': type = l24Lexer::LeftParen; break;
+        case ')': type = l24Lexer::RightParen; break;
+        case '[': type = l24Lexer::LeftSqrBr; break;
+        case ']': type = l24Lexer::RightSqrBr; break;
+        default:
+            break;
+        }
+        if (type != Token::INVALID_TYPE) {
+            _pos += length;
+            return makeToken(type);
+        }
+
+        if (isDigit(c)) {
+            while (_pos < size && isDigit(_data[_pos])) {
+                ++_pos;
+            }
+            return makeToken(l24Lexer::IntLiteral);
+        }
+        if (isIdentStart(c)) {
+            while (_pos < size && (isIdentStart(_data[_pos]) || isDigit(_data[_pos]))) {
+                ++_pos;
+            }
+            // keywords are only matched as a whole identifier
+            type = llvm::StringSwitch<size_t>(_data.slice(start, _pos))
+                       .Case("if", l24Lexer::If)
+                       .Case("then", l24Lexer::Then)
+                       .Case("else", l24Lexer::Else)
+                       .Case("end", l24Lexer::End)
+                       .Case("while", l24Lexer::While)
+                       .Case("continue", l24Lexer::Continue)
+                       .Case("break", l24Lexer::Break)
+                       .Case("return", l24Lexer::Return)
+                       .Case("const", l24Lexer::Const)
+                       .Case("extern", l24Lexer::Extern)
+                       .Cases("int", "char", l24Lexer::Int)
+                       .Case("void", l24Lexer::Void)
+                       .Default(l24Lexer::Ident);
+            return makeToken(type);
+        }
+
+        // no token starts with this byte, skip it
+        reportError(start, start + 1, line, column);
+        ++_pos;
+    }
+}
+
+NativeTokenSource::NativeTokenSource(SourceStream &input, ANTLRErrorListener &listener, size_t line):
+    _input(input),
+    _lexer(input.buffer(), [&listener](size_t line, size_t column, const std::string &msg) {
+        listener.syntaxError(nullptr, nullptr, line, column, msg, nullptr);
+    }, line) {}
+
+std::unique_ptr<Token> NativeTokenSource::nextToken() {
+    NativeToken token = _lexer.lex();
+    // stop is start - 1 for EOF, like the tokens of l24Lexer
+    return getTokenFactory()->create({this, &_input}, token._type, "", Token::DEFAULT_CHANNEL,
+                                     token._start, token._end - 1, token._line, token._column);
+}
+
+} // namespace l24
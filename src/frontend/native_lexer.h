@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "antlr4-runtime.h"
+
+#include "llvm/ADT/StringRef.h"
+
+#include "frontend/source_stream.h"
+
+namespace l24 {
+
+// a token of the native lexer, with the fields of the CommonToken l24Lexer would create
+struct NativeToken {
+    // l24Lexer::If, ..., antlr4::Token::EOF at the end of the source
+    size_t _type = antlr4::Token::INVALID_TYPE;
+    // [_start, _end) in the source, empty for EOF
+    size_t _start = 0;
+    size_t _end = 0;
+    size_t _line = 1;
+    size_t _column = 0;
+};
+
+// Hand-written lexer for the tokens of grammar/l24.g4.
+// It produces the same tokens as the generated l24Lexer (types, offsets, lines and
+// columns), but dispatches on the first byte of a token instead of simulating the
+// lexer ATN. Runs of blanks and the bodies of comments and string literals are scanned
+// 16 bytes at a time with SSE2 where available. Lexical errors are reported with the
+// messages of l24Lexer and the offending bytes are skipped.
+class NativeLexer {
+public:
+    using ErrorHandler = std::function<void(size_t line, size_t column, const std::string &msg)>;
+
+    // data starts at the beginning of line
+    NativeLexer(llvm::StringRef data, ErrorHandler on_error, size_t line = 1):
+        _data(data), _on_error(std::move(on_error)), _line(line) {}
+
+    // next token, whitespace, newlines and comments are skipped
+    NativeToken lex();
+
+    llvm::StringRef text(const NativeToken &token) const { return _data.slice(token._start, token._end); }
+    size_t line() const { return _line; }
+    size_t column() const { return _pos - _line_start; }
+
+private:
+    // move _pos to end, counting the newlines in between
+    void advanceTo(size_t end);
+    void reportError(size_t start, size_t end, size_t line, size_t column);
+
+    llvm::StringRef _data;
+    ErrorHandler _on_error;
+    size_t _pos = 0;
+    size_t _line;
+    // offset of the first byte of the current line
+    size_t _line_start = 0;
+};
+
+// NativeLexer as a drop-in TokenSource for l24Parser, lexical errors go to listener
+class NativeTokenSource : public antlr4::TokenSource {
+public:
+    NativeTokenSource(SourceStream &input, antlr4::ANTLRErrorListener &listener, size_t line = 1);
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+    size_t getLine() const override { return _lexer.line(); }
+    size_t getCharPositionInLine() override { return _lexer.column(); }
+    antlr4::CharStream *getInputStream() override { return &_input; }
+    std::string getSourceName() override { return _input.getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken> *getTokenFactory() override {
+        return antlr4::CommonTokenFactory::DEFAULT.get();
+    }
+
+private:
+    SourceStream &_input;
+    NativeLexer _lexer;
+};
+
+} // namespace l24
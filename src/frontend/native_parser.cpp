@@ -0,0 +1,512 @@
+#include <string>
+#include <vector>
+
+#include "l24Lexer.h"
+
+#include "frontend/native_parser.h"
+
+using antlr4::Token;
+
+namespace l24 {
+
+namespace {
+// binding strength of a binary operator, 0 if type isn't one. all of them are left
+// associative, like the left-recursive rules lOrExp ... mulExp
+unsigned precedence(size_t type) {
+    switch (type) {
+    case l24Lexer::LogicalOr:
+        return 1;
+    case l24Lexer::LogicalAnd:
+        return 2;
+    case l24Lexer::Eq:
+    case l24Lexer::NotEq:
+        return 3;
+    case l24Lexer::Less:
+    case l24Lexer::Greater:
+    case l24Lexer::LessEq:
+    case l24Lexer::GreaterEq:
+        return 4;
+    case l24Lexer::Plus:
+    case l24Lexer::Minus:
+        return 5;
+    case l24Lexer::Star:
+    case l24Lexer::Slash:
+    case l24Lexer::Percentage:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+BinaryOp binaryOp(size_t type) {
+    switch (type) {
+    case l24Lexer::LogicalOr: return BinaryOp::Or;
+    case l24Lexer::LogicalAnd: return BinaryOp::And;
+    case l24Lexer::Eq: return BinaryOp::Eq;
+    case l24Lexer::NotEq: return BinaryOp::Ne;
+    case l24Lexer::Less: return BinaryOp::Lt;
+    case l24Lexer::Greater: return BinaryOp::Gt;
+    case l24Lexer::LessEq: return BinaryOp::Le;
+    case l24Lexer::GreaterEq: return BinaryOp::Ge;
+    case l24Lexer::Plus: return BinaryOp::Add;
+    case l24Lexer::Minus: return BinaryOp::Sub;
+    case l24Lexer::Star: return BinaryOp::Mul;
+    case l24Lexer::Slash: return BinaryOp::Div;
+    default: return BinaryOp::Rem;
+    }
+}
+} // namespace
+
+NativeParser::NativeParser(llvm::StringRef source, ASTArena &arena, std::vector<std::string> &errors,
+                           size_t line):
+    _lexer(source, [&errors](size_t line, size_t column, const std::string &msg) {
+        errors.push_back(std::to_string(line) + ":" + std::to_string(column) + ": " + msg);
+    }, line),
+    _arena(arena), _errors(errors) {}
+
+ProgNode *NativeParser::parse() {
+    ProgNode *program;
+    try {
+        program = parseProgram();
+    } catch (SyntaxError &) {
+        return nullptr;
+    }
+    // lexical errors don't stop the parser, like with l24Lexer
+    return _errors.empty() ? program : nullptr;
+}
+
+const NativeToken &NativeParser::peek(unsigned n) {
+    while (_count <= n) {
+        _tokens[(_head + _count) % Lookahead] = _lexer.lex();
+        ++_count;
+    }
+    return _tokens[(_head + n) % Lookahead];
+}
+
+void NativeParser::consume() {
+    peek();
+    _head = (_head + 1) % Lookahead;
+    --_count;
+}
+
+bool NativeParser::accept(size_t type) {
+    if (!at(type)) {
+        return false;
+    }
+    consume();
+    return true;
+}
+
+void NativeParser::expect(size_t type, const char *display) {
+    if (!accept(type)) {
+        mismatched(display);
+    }
+}
+
+void NativeParser::mismatched(const char *display) {
+    error(std::string("mismatched input '") + (at(Token::EOF) ? "<EOF>" : text().str()) +
+          "' expecting " + display);
+}
+
+void NativeParser::error(const std::string &msg) {
+    const auto &token = peek();
+    _errors.push_back(std::to_string(token._line) + ":" + std::to_string(token._column) + ": " + msg);
+    throw SyntaxError();
+}
+
+void NativeParser::noViableAlternative() {
+    error("no viable alternative at input '" + (at(Token::EOF) ? std::string("<EOF>") : text().str()) + "'");
+}
+
+Symbol NativeParser::ident() {
+    if (!at(l24Lexer::Ident)) {
+        mismatched("Ident");
+    }
+    Symbol symbol = _arena.intern(text());
+    consume();
+    return symbol;
+}
+
+ProgNode *NativeParser::parseProgram() {
+    std::vector<ASTNode *> items;
+    do {
+        items.push_back(parseItem());
+    } while (!at(Token::EOF));
+    auto program = _arena.create<ProgNode>();
+    program->_items = _arena.copyList(items);
+    return program;
+}
+
+ItemNode *NativeParser::parseItem() {
+    auto item = _arena.create<ItemNode>();
+    switch (peek()._type) {
+    case l24Lexer::Extern:
+        item->_extern_decl = parseExternDecl();
+        break;
+    case l24Lexer::Void:
+        item->_func = parseFunc();
+        break;
+    case l24Lexer::Const:
+        item->_decl = parseDecl();
+        break;
+    case l24Lexer::Int:
+        // Int Ident '(' starts a function
+        if (peek(2)._type == l24Lexer::LeftParen) {
+            item->_func = parseFunc();
+        } else {
+            item->_decl = parseDecl();
+        }
+        break;
+    default:
+        noViableAlternative();
+    }
+    return item;
+}
+
+ExternDeclNode *NativeParser::parseExternDecl() {
+    auto extern_decl = _arena.create<ExternDeclNode>();
+    expect(l24Lexer::Extern, "'extern'");
+    if (!at(l24Lexer::Int) && !at(l24Lexer::Void)) {
+        noViableAlternative();
+    }
+    bool is_void = at(l24Lexer::Void);
+    extern_decl->_type = _arena.copyString(text());
+    consume();
+    extern_decl->_ident = ident();
+    if (is_void || at(l24Lexer::LeftParen)) {
+        extern_decl->_is_func = true;
+        expect(l24Lexer::LeftParen, "'('");
+        extern_decl->_param = parseFuncFParams();
+        expect(l24Lexer::RightParen, "')'");
+        expect(l24Lexer::SemiColon, "';'");
+        return extern_decl;
+    }
+
+    if (accept(l24Lexer::LeftSqrBr)) {
+        extern_decl->_is_array = true;
+        if (!at(l24Lexer::RightSqrBr)) {
+            extern_decl->_exp = parseExp();
+        }
+        expect(l24Lexer::RightSqrBr, "']'");
+    }
+    expect(l24Lexer::SemiColon, "';'");
+    return extern_decl;
+}
+
+FuncNode *NativeParser::parseFunc() {
+    auto func = _arena.create<FuncNode>();
+    func->_type = _arena.copyString(text());
+    consume();
+    func->_ident = ident();
+    expect(l24Lexer::LeftParen, "'('");
+    func->_param = parseFuncFParams();
+    expect(l24Lexer::RightParen, "')'");
+    func->_block = parseBlock();
+    return func;
+}
+
+FuncFParamsNode *NativeParser::parseFuncFParams() {
+    auto func_f_params_node = _arena.create<FuncFParamsNode>();
+    if (at(l24Lexer::RightParen)) {
+        return func_f_params_node;
+    }
+    std::vector<ASTNode *> params;
+    do {
+        params.push_back(parseFuncFParam());
+    } while (accept(l24Lexer::Comm));
+    func_f_params_node->_params = _arena.copyList(params);
+    return func_f_params_node;
+}
+
+FuncFParamNode *NativeParser::parseFuncFParam() {
+    auto func_f_param_node = _arena.create<FuncFParamNode>();
+    if (!at(l24Lexer::Int)) {
+        mismatched("Int");
+    }
+    llvm::StringRef type = text();
+    consume();
+    func_f_param_node->_ident = ident();
+    // pointer
+    if (accept(l24Lexer::LeftSqrBr)) {
+        expect(l24Lexer::RightSqrBr, "']'");
+        func_f_param_node->_type = "pointer";
+    } else {
+        func_f_param_node->_type = _arena.copyString(type);
+    }
+    return func_f_param_node;
+}
+
+llvm::ArrayRef<ExprNode *> NativeParser::parseFuncRParams() {
+    if (at(l24Lexer::RightParen)) {
+        return {};
+    }
+    std::vector<ExprNode *> args;
+    do {
+        args.push_back(parseExp());
+    } while (accept(l24Lexer::Comm));
+    return _arena.copyList(args);
+}
+
+BlockNode *NativeParser::parseBlock() {
+    auto block = _arena.create<BlockNode>();
+    expect(l24Lexer::LeftBrace, "'{'");
+    std::vector<ASTNode *> block_items;
+    while (!accept(l24Lexer::RightBrace)) {
+        if (at(Token::EOF)) {
+            mismatched("'}'");
+        }
+        block_items.push_back(parseBlockItem());
+    }
+    block->_block_items = _arena.copyList(block_items);
+    return block;
+}
+
+BlockItemNode *NativeParser::parseBlockItem() {
+    auto blk_item_node = _arena.create<BlockItemNode>();
+    if (at(l24Lexer::Const) || at(l24Lexer::Int)) {
+        blk_item_node->_decl = parseDecl();
+    } else {
+        blk_item_node->_stmt = parseStmt();
+    }
+    return blk_item_node;
+}
+
+DeclNode *NativeParser::parseDecl() {
+    auto decl_node = _arena.create<DeclNode>();
+    if (at(l24Lexer::Const)) {
+        decl_node->_const_decl = parseConstDecl();
+    } else {
+        decl_node->_var_decl = parseVarDecl();
+    }
+    return decl_node;
+}
+
+ConstDeclNode *NativeParser::parseConstDecl() {
+    auto const_decl_node = _arena.create<ConstDeclNode>();
+    expect(l24Lexer::Const, "'const'");
+    if (!at(l24Lexer::Int)) {
+        mismatched("Int");
+    }
+    const_decl_node->_b_type = _arena.copyString(text());
+    consume();
+    std::vector<ASTNode *> const_defs;
+    do {
+        const_defs.push_back(parseConstDef());
+    } while (accept(l24Lexer::Comm));
+    expect(l24Lexer::SemiColon, "';'");
+    const_decl_node->_const_defs = _arena.copyList(const_defs);
+    return const_decl_node;
+}
+
+VarDeclNode *NativeParser::parseVarDecl() {
+    auto var_decl_node = _arena.create<VarDeclNode>();
+    if (!at(l24Lexer::Int)) {
+        mismatched("Int");
+    }
+    var_decl_node->_b_type = _arena.copyString(text());
+    consume();
+    std::vector<ASTNode *> var_defs;
+    do {
+        var_defs.push_back(parseVarDef());
+    } while (accept(l24Lexer::Comm));
+    expect(l24Lexer::SemiColon, "';'");
+    var_decl_node->_var_defs = _arena.copyList(var_defs);
+    return var_decl_node;
+}
+
+ConstDefNode *NativeParser::parseConstDef() {
+    auto const_def_node = _arena.create<ConstDefNode>();
+    const_def_node->_ident = ident();
+    if (accept(l24Lexer::LeftSqrBr)) {
+        const_def_node->_exp = parseExp();
+        expect(l24Lexer::RightSqrBr, "']'");
+    }
+    expect(l24Lexer::Assign, "'='");
+    const_def_node->_init_val = parseInitVal();
+    return const_def_node;
+}
+
+VarDefNode *NativeParser::parseVarDef() {
+    auto var_def_node = _arena.create<VarDefNode>();
+    var_def_node->_ident = ident();
+    if (accept(l24Lexer::LeftSqrBr)) {
+        var_def_node->_exp = parseExp();
+        expect(l24Lexer::RightSqrBr, "']'");
+    }
+    if (accept(l24Lexer::Assign)) {
+        var_def_node->_init_val = parseInitVal();
+    }
+    return var_def_node;
+}
+
+InitValNode *NativeParser::parseInitVal() {
+    auto init_val_node = _arena.create<InitValNode>();
+    if (at(l24Lexer::StringLiteral)) {
+        init_val_node->_is_array = true;
+        init_val_node->_string_literal = _arena.copyString(text().drop_front().drop_back());
+        consume();
+        return init_val_node;
+    }
+    if (!accept(l24Lexer::LeftBrace)) {
+        ASTNode *exp = parseExp();
+        init_val_node->_exp = _arena.copyList(llvm::ArrayRef<ASTNode *>(exp));
+        return init_val_node;
+    }
+    init_val_node->_is_array = true;
+    std::vector<ASTNode *> exps;
+    if (!at(l24Lexer::RightBrace)) {
+        do {
+            exps.push_back(parseExp());
+        } while (accept(l24Lexer::Comm));
+    }
+    expect(l24Lexer::RightBrace, "'}'");
+    init_val_node->_exp = _arena.copyList(exps);
+    return init_val_node;
+}
+
+StmtNode *NativeParser::parseStmt() {
+    auto stmt = _arena.create<StmtNode>();
+    switch (peek()._type) {
+    case l24Lexer::Return:
+        consume();
+        stmt->_is_ret_stmt = true;
+        if (!at(l24Lexer::SemiColon)) {
+            stmt->_expr = parseExp();
+        }
+        expect(l24Lexer::SemiColon, "';'");
+        return stmt;
+    case l24Lexer::LeftBrace:
+        stmt->_block = parseBlock();
+        return stmt;
+    case l24Lexer::Continue:
+        consume();
+        stmt->_is_continue_stmt = true;
+        expect(l24Lexer::SemiColon, "';'");
+        return stmt;
+    case l24Lexer::Break:
+        consume();
+        stmt->_is_break_stmt = true;
+        expect(l24Lexer::SemiColon, "';'");
+        return stmt;
+    case l24Lexer::If:
+        consume();
+        expect(l24Lexer::LeftParen, "'('");
+        stmt->_expr = parseExp();
+        expect(l24Lexer::RightParen, "')'");
+        expect(l24Lexer::Then, "'then'");
+        stmt->_if_stmt = parseStmt();
+        if (accept(l24Lexer::Else)) {
+            stmt->_else_stmt = parseStmt();
+        }
+        expect(l24Lexer::End, "'end'");
+        return stmt;
+    case l24Lexer::While:
+        consume();
+        expect(l24Lexer::LeftParen, "'('");
+        stmt->_expr = parseExp();
+        expect(l24Lexer::RightParen, "')'");
+        stmt->_while_stmt = parseStmt();
+        return stmt;
+    case l24Lexer::SemiColon:
+        consume();
+        return stmt;
+    default:
+        break;
+    }
+
+    // lVal '=' exp ';' or exp ';'. an expression that starts with Ident and is a single
+    // VarRefNode can only be Ident ('[' exp ']')?, which is exactly lVal
+    bool starts_with_ident = at(l24Lexer::Ident);
+    ExprNode *exp = parseExp();
+    if (starts_with_ident && exp->_kind == ExprNode::Kind::VarRef && accept(l24Lexer::Assign)) {
+        auto l_val = static_cast<VarRefNode *>(exp);
+        stmt->_l_val = l_val->_ident;
+        stmt->_sub_idx = l_val->_exp;
+        exp = parseExp();
+    }
+    stmt->_expr = exp;
+    expect(l24Lexer::SemiColon, "';'");
+    return stmt;
+}
+
+ExprNode *NativeParser::parseExp() {
+    return parseBinaryExp(parseUnaryExp(), 1);
+}
+
+ExprNode *NativeParser::parseBinaryExp(ExprNode *lhs, unsigned min_precedence) {
+    for (;;) {
+        unsigned prec = precedence(peek()._type);
+        if (prec < min_precedence) {
+            return lhs;
+        }
+        BinaryOp op = binaryOp(peek()._type);
+        consume();
+        ExprNode *rhs = parseUnaryExp();
+        // operators that bind tighter take rhs as their left operand
+        while (precedence(peek()._type) > prec) {
+            rhs = parseBinaryExp(rhs, prec + 1);
+        }
+        lhs = _arena.create<BinaryExprNode>(op, lhs, rhs);
+    }
+}
+
+ExprNode *NativeParser::parseUnaryExp() {
+    switch (peek()._type) {
+    case l24Lexer::Plus:
+        // unary plus
+        consume();
+        return parseUnaryExp();
+    case l24Lexer::Minus:
+        consume();
+        return _arena.create<UnaryExprNode>(UnaryOp::Neg, parseUnaryExp());
+    case l24Lexer::Not:
+        consume();
+        return _arena.create<UnaryExprNode>(UnaryOp::Not, parseUnaryExp());
+    case l24Lexer::Ident:
+        if (peek(1)._type == l24Lexer::LeftParen) {
+            auto call = _arena.create<CallNode>();
+            call->_func_ident = ident();
+            consume();
+            call->_args = parseFuncRParams();
+            expect(l24Lexer::RightParen, "')'");
+            return call;
+        }
+        return parsePrimaryExp();
+    default:
+        return parsePrimaryExp();
+    }
+}
+
+ExprNode *NativeParser::parsePrimaryExp() {
+    switch (peek()._type) {
+    case l24Lexer::LeftParen: {
+        consume();
+        ExprNode *exp = parseExp();
+        expect(l24Lexer::RightParen, "')'");
+        return exp;
+    }
+    case l24Lexer::IntLiteral: {
+        int64_t value;
+        if (text().getAsInteger(10, value)) {
+            error("integer literal out of range");
+        }
+        auto literal = _arena.create<LiteralNode>(value);
+        consume();
+        return literal;
+    }
+    case l24Lexer::Ident: {
+        // lVal
+        auto var_ref = _arena.create<VarRefNode>();
+        var_ref->_ident = ident();
+        if (accept(l24Lexer::LeftSqrBr)) {
+            var_ref->_exp = parseExp();
+            expect(l24Lexer::RightSqrBr, "']'");
+        }
+        return var_ref;
+    }
+    default:
+        noViableAlternative();
+    }
+}
+
+} // namespace l24
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "frontend/ast.h"
+#include "frontend/ast_arena.h"
+#include "frontend/native_lexer.h"
+
+namespace l24 {
+
+// Recursive-descent parser for grammar/l24.g4 that builds the AST in one pass.
+// No parse tree is created and no ATN prediction runs: every rule is decided by at most
+// three tokens of lookahead, and the left-recursive expression rules are parsed by
+// precedence climbing. The AST is the same one ASTBuilder builds from the parse tree of
+// l24Parser. Tokens are pulled from a NativeLexer one at a time.
+// Parsing stops at the first syntax error, its message follows those of l24Parser.
+class NativeParser {
+public:
+    // nodes are allocated in arena, errors ("line:col: message") are appended to errors.
+    // source starts at the beginning of line
+    NativeParser(llvm::StringRef source, ASTArena &arena, std::vector<std::string> &errors,
+                 size_t line = 1);
+
+    // the items of source, nullptr if there are lexical or syntax errors
+    ProgNode *parse();
+
+private:
+    // thrown at the first syntax error, after it is appended to _errors
+    struct SyntaxError {};
+
+    // the current token is peek(0)
+    const NativeToken &peek(unsigned n = 0);
+    bool at(size_t type) { return peek()._type == type; }
+    void consume();
+    // consume the current token if it is of type
+    bool accept(size_t type);
+    // consume a token of type, display is used in the error message ("';'")
+    void expect(size_t type, const char *display);
+    [[noreturn]] void mismatched(const char *display);
+    [[noreturn]] void error(const std::string &msg);
+    [[noreturn]] void noViableAlternative();
+    llvm::StringRef text() { return _lexer.text(peek()); }
+    Symbol ident();
+
+    ProgNode *parseProgram();
+    ItemNode *parseItem();
+    ExternDeclNode *parseExternDecl();
+    FuncNode *parseFunc();
+    FuncFParamsNode *parseFuncFParams();
+    FuncFParamNode *parseFuncFParam();
+    llvm::ArrayRef<ExprNode *> parseFuncRParams();
+    BlockNode *parseBlock();
+    BlockItemNode *parseBlockItem();
+    DeclNode *parseDecl();
+    ConstDeclNode *parseConstDecl();
+    VarDeclNode *parseVarDecl();
+    ConstDefNode *parseConstDef();
+    VarDefNode *parseVarDef();
+    InitValNode *parseInitVal();
+    StmtNode *parseStmt();
+
+    ExprNode *parseExp();
+    // binary operators of at least min_precedence, with lhs as the first operand
+    ExprNode *parseBinaryExp(ExprNode *lhs, unsigned min_precedence);
+    ExprNode *parseUnaryExp();
+    ExprNode *parsePrimaryExp();
+
+    NativeLexer _lexer;
+    ASTArena &_arena;
+    std::vector<std::string> &_errors;
+    // ring buffer of the current token and the ones after it
+    static constexpr unsigned Lookahead = 4;
+    NativeToken _tokens[Lookahead];
+    unsigned _head = 0;
+    unsigned _count = 0;
+};
+
+} // namespace l24
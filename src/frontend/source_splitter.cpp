@@ -0,0 +1,102 @@
+#include "frontend/source_splitter.h"
+
+namespace l24 {
+
+std::vector<SourceChunk> splitSource(llvm::StringRef source, size_t chunk_size) {
+    std::vector<SourceChunk> chunks;
+    SourceChunk chunk{0, 0, 1};
+    size_t line = 1;
+    unsigned depth = 0;
+    // the '{' at depth 0 followed a ')', so it opened a function body and not an initVal
+    bool function_body = false;
+    // the last token of the current line so far ends a top-level item
+    bool item_end = false;
+    // last byte of the last token, and the offset after it
+    char last = '\0';
+    size_t token_end = 0;
+    const size_t size = source.size();
+    for (size_t pos = 0; pos < size; ++pos) {
+        char c = source[pos];
+        switch (c) {
+        case '\n':
+            ++line;
+            if (item_end && pos + 1 - chunk._begin >= chunk_size) {
+                chunk._end = pos + 1;
+                chunks.push_back(chunk);
+                chunk = SourceChunk{pos + 1, 0, line};
+                // the next chunk needs an item of its own
+                item_end = false;
+            }
+            continue;
+        case ' ':
+        case '\t':
+        case '\r':
+            continue;
+        case '/':
+            if (pos + 1 < size && source[pos + 1] == '/') {
+                // up to the newline, which may end the chunk
+                size_t newline = source.find('\n', pos + 2);
+                pos = (newline == llvm::StringRef::npos ? size : newline) - 1;
+                continue;
+            }
+            if (pos + 1 < size && source[pos + 1] == '*') {
+                size_t end = source.find("*/", pos + 2);
+                if (end == llvm::StringRef::npos) {
+                    // lexed as '/' '*' ..., don't split the rest
+                    pos = size;
+                    continue;
+                }
+                line += source.slice(pos, end).count('\n');
+                pos = end + 1;
+                continue;
+            }
+            break;
+        case '"': {
+            size_t end = source.find('"', pos + 1);
+            if (end == llvm::StringRef::npos) {
+                pos = size;
+                continue;
+            }
+            line += source.slice(pos, end).count('\n');
+            pos = end;
+            break;
+        }
+        case '{':
+            if (depth++ == 0) {
+                function_body = last == ')';
+            }
+            break;
+        case '}':
+            if (depth > 0 && --depth == 0 && function_body) {
+                item_end = true;
+                last = c;
+                token_end = pos + 1;
+                continue;
+            }
+            break;
+        case ';':
+            if (depth == 0) {
+                item_end = true;
+                last = c;
+                token_end = pos + 1;
+                continue;
+            }
+            break;
+        default:
+            break;
+        }
+        item_end = false;
+        last = source[pos];
+        token_end = pos + 1;
+    }
+    if (!chunks.empty() && token_end <= chunk._begin) {
+        // only blanks and comments are left, which are no item on their own
+        chunks.back()._end = size;
+        return chunks;
+    }
+    chunk._end = size;
+    chunks.push_back(chunk);
+    return chunks;
+}
+
+} // namespace l24
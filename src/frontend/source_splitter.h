@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace l24 {
+
+// [_begin, _end) of a source, starting at the beginning of line _line
+struct SourceChunk {
+    size_t _begin;
+    size_t _end;
+    size_t _line;
+};
+
+// Split source into chunks of whole top-level items, so that they can be parsed
+// independently. A chunk ends after the newline of a line whose last token ends an item:
+// a ';' or the '}' of a function body outside of any braces. Braces, ';' and newlines in
+// string literals and comments are skipped. Chunks are at least chunk_size bytes except
+// the last one, together they cover the whole source.
+std::vector<SourceChunk> splitSource(llvm::StringRef source, size_t chunk_size);
+
+} // namespace l24
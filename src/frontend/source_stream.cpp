@@ -0,0 +1,47 @@
+#include <algorithm>
+
+#include "frontend/source_stream.h"
+
+namespace l24 {
+
+void SourceStream::consume() {
+    if (_pos >= _data.size()) {
+        throw antlr4::IllegalStateException("cannot consume EOF");
+    }
+    ++_pos;
+}
+
+size_t SourceStream::LA(ssize_t i) {
+    if (i == 0) {
+        // undefined
+        return 0;
+    }
+    // LA(-1) is the last consumed char
+    ssize_t pos = static_cast<ssize_t>(_pos) + (i > 0 ? i - 1 : i);
+    if (pos < 0 || pos >= static_cast<ssize_t>(_data.size())) {
+        return antlr4::IntStream::EOF;
+    }
+    return static_cast<unsigned char>(_data[pos]);
+}
+
+void SourceStream::seek(size_t index) {
+    _pos = std::min(index, _data.size());
+}
+
+std::string SourceStream::getSourceName() const {
+    return _name.empty() ? antlr4::IntStream::UNKNOWN_SOURCE_NAME : _name;
+}
+
+std::string SourceStream::getText(const antlr4::misc::Interval &interval) {
+    if (interval.a < 0 || interval.b < interval.a) {
+        return "";
+    }
+    size_t start = static_cast<size_t>(interval.a);
+    size_t stop = std::min(static_cast<size_t>(interval.b), _data.size() - 1);
+    if (start >= _data.size()) {
+        return "";
+    }
+    return _data.slice(start, stop + 1).str();
+}
+
+} // namespace l24
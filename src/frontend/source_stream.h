@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#include "antlr4-runtime.h"
+
+#include "llvm/Support/MemoryBufferRef.h"
+
+namespace l24 {
+
+// A CharStream that reads the bytes of a (usually memory-mapped) buffer in place.
+// ANTLRInputStream copies the whole source and decodes it into a UTF-32 string first,
+// l24 tokens are all ASCII, so the lexer can run on the bytes directly. Bytes >= 0x80
+// only appear in comments and string literals, which match any character, and
+// getText() returns the original UTF-8 bytes.
+// The buffer must outlive the stream and every token created from it.
+class SourceStream : public antlr4::CharStream {
+public:
+    explicit SourceStream(llvm::MemoryBufferRef buffer):
+        _data(buffer.getBuffer()), _name(buffer.getBufferIdentifier().str()) {}
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    // the whole buffer is always available, marks are no-ops
+    ssize_t mark() override { return -1; }
+    void release(ssize_t marker) override {}
+    size_t index() override { return _pos; }
+    void seek(size_t index) override;
+    size_t size() override { return _data.size(); }
+    std::string getSourceName() const override;
+
+    std::string getText(const antlr4::misc::Interval &interval) override;
+    std::string toString() const override { return _data.str(); }
+
+    // the bytes of the buffer, for lexers that scan them directly
+    llvm::StringRef buffer() const { return _data; }
+
+private:
+    llvm::StringRef _data;
+    std::string _name;
+    size_t _pos = 0;
+};
+
+} // namespace l24
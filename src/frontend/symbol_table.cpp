@@ -0,0 +1,13 @@
+#include "frontend/symbol_table.h"
+
+namespace l24 {
+
+Symbol SymbolTable::intern(llvm::StringRef name) {
+    auto [entry, inserted] = _symbols.try_emplace(name, static_cast<Symbol>(_names.size()));
+    if (inserted) {
+        _names.push_back(entry->getKey());
+    }
+    return entry->getValue();
+}
+
+} // namespace l24
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace l24 {
+
+// compact id of an interned identifier, only meaningful with its SymbolTable
+using Symbol = uint32_t;
+constexpr Symbol NoSymbol = ~Symbol(0);
+
+// Interns the identifiers of one AST.
+// Every distinct name is hashed once while building the AST, later phases compare and
+// key maps on Symbols and only look the name up for IR value names and diagnostics.
+class SymbolTable {
+public:
+    Symbol intern(llvm::StringRef name);
+    llvm::StringRef name(Symbol symbol) const { return _names[symbol]; }
+    size_t size() const { return _names.size(); }
+
+private:
+    llvm::StringMap<Symbol> _symbols;
+    // keys of _symbols, whose entries never move
+    std::vector<llvm::StringRef> _names;
+};
+
+} // namespace l24
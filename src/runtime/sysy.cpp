@@ -0,0 +1,109 @@
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+#include "runtime/sysy.h"
+
+extern "C" {
+
+int64_t getint() {
+    int64_t a = 0;
+    if (std::scanf("%" SCNd64, &a) != 1) {
+        return 0;
+    }
+    return a;
+}
+
+void putint(int64_t a) {
+    std::printf("%" PRId64, a);
+}
+
+int64_t getch() {
+    return std::getchar();
+}
+
+void putch(int64_t a) {
+    std::putchar(static_cast<int>(a));
+}
+
+int64_t getarray(int64_t arr[]) {
+    int64_t n = getint();
+    for (int64_t i = 0; i < n; ++i) {
+        arr[i] = getint();
+    }
+    return n;
+}
+
+int64_t scan(int64_t arr[]) {
+    return getarray(arr);
+}
+
+void putarray(int64_t n, int64_t arr[]) {
+    std::printf("%" PRId64 ":", n);
+    for (int64_t i = 0; i < n; ++i) {
+        std::printf(" %" PRId64, arr[i]);
+    }
+    std::printf("\n");
+}
+
+void print(int64_t n, int64_t arr[]) {
+    putarray(n, arr);
+}
+
+void printStr(int64_t n, int64_t str[]) {
+    for (int64_t i = 0; i < n; ++i) {
+        std::putchar(static_cast<int>(str[i]));
+    }
+}
+
+void plusStrStr(int64_t a[], int64_t b[], int64_t len_a, int64_t len_b, int64_t out[]) {
+    for (int64_t i = 0; i < len_a; ++i) {
+        out[i] = a[i];
+    }
+    for (int64_t i = 0; i < len_b; ++i) {
+        out[len_a + i] = b[i];
+    }
+}
+
+void mulStrNum(int64_t str[], int64_t num, int64_t len, int64_t out[]) {
+    for (int64_t k = 0; k < num; ++k) {
+        for (int64_t i = 0; i < len; ++i) {
+            out[k * len + i] = str[i];
+        }
+    }
+}
+
+void plusStrNum(int64_t str[], int64_t num, int64_t len, int64_t out[]) {
+    for (int64_t i = 0; i < len; ++i) {
+        out[i] = str[i];
+    }
+    std::string digits = std::to_string(num);
+    for (size_t i = 0; i < digits.size(); ++i) {
+        out[len + i] = digits[i];
+    }
+}
+
+} // extern "C"
+
+namespace l24 {
+
+const RuntimeSymbol *getRuntimeSymbols(unsigned &count) {
+    static const RuntimeSymbol symbols[] = {
+        {"getint", reinterpret_cast<void *>(&getint)},
+        {"putint", reinterpret_cast<void *>(&putint)},
+        {"getch", reinterpret_cast<void *>(&getch)},
+        {"putch", reinterpret_cast<void *>(&putch)},
+        {"getarray", reinterpret_cast<void *>(&getarray)},
+        {"scan", reinterpret_cast<void *>(&scan)},
+        {"putarray", reinterpret_cast<void *>(&putarray)},
+        {"print", reinterpret_cast<void *>(&print)},
+        {"printStr", reinterpret_cast<void *>(&printStr)},
+        {"plusStrStr", reinterpret_cast<void *>(&plusStrStr)},
+        {"mulStrNum", reinterpret_cast<void *>(&mulStrNum)},
+        {"plusStrNum", reinterpret_cast<void *>(&plusStrNum)},
+    };
+    count = sizeof(symbols) / sizeof(symbols[0]);
+    return symbols;
+}
+
+} // namespace l24
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// The sysy runtime library, the same functions CodeGenContext::codeGenStandardLibrary
+// declares. Every l24 int (and char of a string) is 64 bits wide.
+extern "C" {
+int64_t getint();
+void putint(int64_t a);
+int64_t getch();
+void putch(int64_t a);
+
+// read a length n and then n ints into arr, returns n
+int64_t getarray(int64_t arr[]);
+int64_t scan(int64_t arr[]);
+// print "n: a[0] a[1] ..." and a newline
+void putarray(int64_t n, int64_t arr[]);
+void print(int64_t n, int64_t arr[]);
+
+// strings are arrays of chars without a terminator, lengths are passed explicitly
+void printStr(int64_t n, int64_t str[]);
+// out = a + b
+void plusStrStr(int64_t a[], int64_t b[], int64_t len_a, int64_t len_b, int64_t out[]);
+// out = str repeated num times
+void mulStrNum(int64_t str[], int64_t num, int64_t len, int64_t out[]);
+// out = str followed by the decimal digits of num
+void plusStrNum(int64_t str[], int64_t num, int64_t len, int64_t out[]);
+}
+
+namespace l24 {
+
+struct RuntimeSymbol {
+    const char *_name;
+    void *_addr;
+};
+
+// name and address of every runtime function, for registering them in a JIT
+const RuntimeSymbol *getRuntimeSymbols(unsigned &count);
+
+} // namespace l24
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Timer.h"
+
+namespace l24 {
+
+// Time one compile phase (lexing, parsing, IR generation, ...).
+// The phase shows up in the -ftime-trace JSON and, when -ftime-report sets
+// llvm::TimePassesIsEnabled, in the "l24 Compile Phases" timer group.
+// The timer group is not thread-safe, work that runs concurrently within a phase passes
+// enabled = false and is only timed as a whole.
+class PhaseTimer {
+public:
+    PhaseTimer(llvm::StringRef name, llvm::StringRef desc, bool enabled = true):
+        _trace(desc),
+        _timer(name, desc, "l24", "l24 Compile Phases", enabled && llvm::TimePassesIsEnabled) {}
+
+private:
+    llvm::TimeTraceScope _trace;
+    llvm::NamedRegionTimer _timer;
+};
+
+} // namespace l24
@@ -0,0 +1,93 @@
+#!/bin/bash
+# an AST written with --dump-ast and read back with --load-ast must give the same IR as
+# the source, and writing the loaded AST again must give the same file
+
+out_dir=$(mktemp -d /tmp/l24_ast.XXXXXX)
+for file in ../*/*.l24; do
+  ../../build/bin/l24 $file --dump-ast -emit-llvm -o $out_dir/source.ll 2> /dev/null
+  if [ $? != 0 ]; then
+    # sources with syntax errors have no AST
+    continue
+  fi
+  ../../build/bin/l24 $out_dir/source.ast --load-ast --dump-ast -emit-llvm -o $out_dir/loaded.ll
+  if [ $? != 0 ]; then
+    echo "AST of ${file} can't be loaded"
+    rm -rf $out_dir
+    exit 1
+  fi
+
+  diff $out_dir/source.ll $out_dir/loaded.ll
+  if [ $(echo $?) != 0 ]; then
+    echo "IR of ${file} differs after loading its AST"
+    rm -rf $out_dir
+    exit 1
+  fi
+  cmp $out_dir/source.ast $out_dir/loaded.ast
+  if [ $(echo $?) != 0 ]; then
+    echo "AST of ${file} differs after loading it"
+    rm -rf $out_dir
+    exit 1
+  fi
+  echo "test ${file} success"
+done
+
+# a truncated AST file is rejected
+head -c 20 $out_dir/source.ast > $out_dir/truncated.ast
+if ../../build/bin/l24 $out_dir/truncated.ast --load-ast -emit-llvm -o /dev/null 2> /dev/null; then
+  echo "truncated AST file was accepted"
+  rm -rf $out_dir
+  exit 1
+fi
+echo "test truncated AST success"
+
+# crafted files that are well formed but can't be compiled are rejected too: an item
+# without a child, an initializer of 20000 nested unary expressions, and an if statement
+# without a condition
+reject() {
+  local message
+  message=$(../../build/bin/l24 $out_dir/$1.ast --load-ast -emit-llvm -o /dev/null 2>&1)
+  if [ $? == 0 ] || [[ "$message" != *"$2"* ]]; then
+    echo "$1 AST file was not rejected with \"$2\""
+    rm -rf $out_dir
+    exit 1
+  fi
+  echo "test $1 AST success"
+}
+printf 'L24AST\x01\x00\x01\x01\x02\x00\x00\x00' > $out_dir/empty_item.ast
+reject empty_item "expected exactly one child"
+printf 'L24AST\x01\x01\x01a\x01\x01\x02\x09\x00\x0b\x03int\x01\x0d\x01\x0e\x00\x00\x01' > $out_dir/deep.ast
+printf '\x11\x00%.0s' $(seq 20000) >> $out_dir/deep.ast
+printf '\x12\x00\x00\x00\x00' >> $out_dir/deep.ast
+reject deep "nesting too deep"
+printf 'L24AST\x01\x01\x04main\x01\x01\x02\x00\x04\x03int\x01\x00\x07\x01\x08\x00' > $out_dir/if.ast
+printf '\x0f\x00\x00\x00\x00\x00\x0f\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00' >> $out_dir/if.ast
+reject if "missing expression of statement"
+
+# a flat expression longer than the nesting limit is not nested in the file
+echo "int main() { return 1$(printf ' + 1%.0s' $(seq 12000)); }" > $out_dir/flat.l24
+../../build/bin/l24 $out_dir/flat.l24 --dump-ast -emit-llvm -o $out_dir/source.ll
+../../build/bin/l24 $out_dir/source.ast --load-ast -emit-llvm -o $out_dir/loaded.ll
+diff -q $out_dir/source.ll $out_dir/loaded.ll > /dev/null
+if [ $(echo $?) != 0 ]; then
+  echo "IR of a long flat expression differs after loading its AST"
+  rm -rf $out_dir
+  exit 1
+fi
+echo "test flat expression AST success"
+
+# Symbols are numbered in the order the threads intern them, the file must not depend
+# on it
+for ((i = 0; i < 5000; i++)); do
+  echo "int g$i = $i; int f$i(int a$i) { return a$i + g$i; }" >> $out_dir/big.l24
+done
+echo "int main() { return f0(0); }" >> $out_dir/big.l24
+../../build/bin/l24 $out_dir/big.l24 --parse-threads=1 --dump-ast -emit-llvm -o $out_dir/serial.ll
+../../build/bin/l24 $out_dir/big.l24 --parse-threads=4 --dump-ast -emit-llvm -o $out_dir/parallel.ll
+cmp $out_dir/serial.ast $out_dir/parallel.ast
+if [ $(echo $?) != 0 ]; then
+  echo "AST differs between --parse-threads=1 and --parse-threads=4"
+  rm -rf $out_dir
+  exit 1
+fi
+echo "test --parse-threads AST success"
+rm -rf $out_dir
@@ -0,0 +1,38 @@
+#!/bin/bash
+# compile every lv* test in one --batch process, then link and run each object
+
+out_dir=$(mktemp -d /tmp/l24_batch.XXXXXX)
+manifest=$out_dir/manifest
+for file in ../lv*/*.l24; do
+  echo "$file $out_dir/$(basename ${file%.*}).o -O2" >> $manifest
+done
+
+../../build/bin/l24 --batch=$manifest
+if [ $(echo $?) != 0 ]; then
+  echo "batch compilation failed"
+  rm -rf $out_dir
+  exit 1
+fi
+
+for file in ../lv*/*.l24; do
+  name=${file%.*}
+  ../../build/bin/l24 $out_dir/$(basename $name).o -o $out_dir/output
+  tmp_file=$out_dir/$(basename $name).output
+
+  if [ -e $name.in ]; then
+    $out_dir/output < $name.in > "$tmp_file"
+  else
+    $out_dir/output > "$tmp_file"
+  fi
+  echo $? >> "$tmp_file"
+
+  diff "$tmp_file" $name.out
+  if [ $(echo $?) != 0 ]; then
+    echo "result of ${file} is wrong"
+    rm -rf $out_dir
+    exit 1
+  else
+    echo "test ${file} success"
+  fi
+done
+rm -rf $out_dir
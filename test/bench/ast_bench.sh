@@ -0,0 +1,34 @@
+#!/bin/bash
+# AST construction microbenchmark on a generated, expression heavy source file.
+# reports the "AST Building" time (-ftime-report) of several runs and the AST size.
+# usage: ./ast_bench.sh [number of functions, default 20000] [runs, default 5]
+
+count=${1:-20000}
+runs=${2:-5}
+l24=../../build/bin/l24
+src=$(mktemp /tmp/l24_ast_bench_XXXXXX.l24)
+
+for ((i = 0; i < count; i++)); do
+  cat >> "$src" <<EOT
+int g$i(int a, int b, int c) {
+  int x = (a + b * c - $i) % 7 + -a * (b - c) / (c + 1);
+  int y = a < b && b <= c || !(a == c) && a != $i;
+  int z = g$i(x - 1, y + 2, (x + y) * (a - b)) + (((a))) * +b;
+  return x * y + z - (a * $i + b * c) / (1 + a * a + b * b + c * c);
+}
+EOT
+done
+echo "int main() { return 0; }" >> "$src"
+
+echo "source: $(wc -c < "$src") bytes, $count functions"
+for ((run = 0; run < runs; run++)); do
+  $l24 "$src" -emit-llvm -o /dev/null -ftime-report 2>&1 | grep -E "AST Building"
+  status=${PIPESTATUS[0]}
+  if [ $status != 0 ]; then
+    rm -f "$src"
+    exit $status
+  fi
+done
+$l24 "$src" --parse-stats -emit-llvm -o /dev/null | grep "^ast:"
+
+rm -f "$src"
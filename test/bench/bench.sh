@@ -0,0 +1,45 @@
+#!/bin/bash
+# frontend benchmark on a generated source file.
+# reports source loading/parsing time (-ftime-report, tokens are lexed on demand while
+# parsing) and peak memory of l24
+# with both lexers, and the AST arena usage (--parse-stats).
+# usage: ./bench.sh [number of functions, default 20000]
+
+count=${1:-20000}
+l24=../../build/bin/l24
+src=$(mktemp /tmp/l24_bench_XXXXXX.l24)
+
+for ((i = 0; i < count; i++)); do
+  cat >> "$src" <<EOT
+/* function $i */
+int f$i(int n) {
+  int i = 0, sum = 0;
+  while (i < n) {
+    if (i == $i) then {
+      sum = sum + 1;
+    } else {
+      sum = sum + i * 2;
+    } end
+    i = i + 1;
+  }
+  return sum;
+}
+EOT
+done
+echo "int main() { return f0(10); }" >> "$src"
+
+echo "source: $(wc -c < "$src") bytes, $count functions"
+status=0
+for lexer in antlr native; do
+  echo "--lexer=$lexer"
+  /usr/bin/time -f "peak memory: %M KB, wall time: %e s" \
+    $l24 "$src" --lexer=$lexer -emit-llvm -o /dev/null -ftime-report 2>&1 |
+    grep -E "Source Loading|Parsing|AST Building|peak memory"
+  if [ ${PIPESTATUS[0]} != 0 ]; then
+    status=1
+  fi
+done
+$l24 "$src" --parse-stats -emit-llvm -o /dev/null | grep "^ast:"
+
+rm -f "$src"
+exit $status
@@ -0,0 +1,52 @@
+#!/bin/bash
+# parse throughput of the ANTLR and the native parser on a generated source file.
+# the front end time is the sum of the Parsing and AST Building phases of -ftime-report,
+# tokens are lexed on demand while parsing (the native parser also builds the AST there).
+# usage: ./parse_bench.sh [number of functions, default 20000] [--parse-threads values, default "1"]
+
+count=${1:-20000}
+threads_list=${2:-1}
+l24=../../build/bin/l24
+src=$(mktemp /tmp/l24_parse_bench_XXXXXX.l24)
+
+for ((i = 0; i < count; i++)); do
+  cat >> "$src" <<EOT
+// function $i
+int f$i(int a[], int n) {
+  const int k = $i % 7;
+  int i = 0, sum = 0;
+  while (i < n) {
+    if (a[i] * k + 1 >= sum || !(i == $i) && a[i] != -1) then {
+      sum = sum + a[i] * (k - 1) / 2;
+    } else {
+      sum = f$i(a, i) - 1;
+    } end
+    i = i + 1;
+  }
+  return sum;
+}
+EOT
+done
+echo "int main() { return 0; }" >> "$src"
+
+bytes=$(wc -c < "$src")
+echo "source: $bytes bytes, $count functions"
+status=0
+for parser in antlr native; do
+  for threads in $threads_list; do
+    report=$($l24 "$src" --parser=$parser --parse-threads=$threads -emit-llvm -o /dev/null -ftime-report 2>&1)
+    if [ $? != 0 ]; then
+      status=1
+      continue
+    fi
+    # the wall time is the last "<seconds> (<percent>%)" column of a phase. with more than
+    # one thread, AST Building is part of Parsing
+    seconds=$(echo "$report" | grep -E "  (Parsing|AST Building)$" |
+      sed -E 's/.* ([0-9]+\.[0-9]+) +\( *[0-9.]+%\) +[A-Z].*/\1/' | awk '{ sum += $1 } END { print sum }')
+    awk -v parser=$parser -v threads=$threads -v bytes=$bytes -v seconds=$seconds \
+      'BEGIN { printf "--parser=%-7s --parse-threads=%-3s %8.4f s  %8.2f MB/s\n", parser, threads, seconds, bytes / seconds / 1e6 }'
+  done
+done
+
+rm -f "$src"
+exit $status
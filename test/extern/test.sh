@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# every translation unit is compiled on its own, then the objects are linked
+../../build/bin/l24 -c vec.l24 main.l24 >> /dev/null
+if [ $(echo $?) != 0 ]; then
+  echo "runtime error"
+  exit 1
+fi
+
+../../build/bin/l24 vec.o main.o -o output
+if [ $(echo $?) != 0 ]; then
+  echo "link error"
+  rm -f vec.o main.o
+  exit 1
+fi
+
+tmp_file=$(mktemp /tmp/extern.XXXXXX)
+./output > "$tmp_file"
+echo $? >> "$tmp_file"
+
+diff "$tmp_file" main.out
+if [ $(echo $?) != 0 ]; then
+  echo "result of extern is wrong"
+  rm vec.o main.o output "$tmp_file"
+  exit 1
+else
+  echo "test extern success"
+fi
+rm vec.o main.o output "$tmp_file"
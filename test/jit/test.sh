@@ -0,0 +1,26 @@
+#!/bin/bash
+# run every lv* test through the JIT (l24 --run) instead of building an executable
+
+for dir in ../lv*; do
+  for file in $dir/*.l24; do
+    name=${file%.*}
+    tmp_file=$(mktemp /tmp/$(basename $name).output.XXXXXX)
+
+    if [ -e $name.in ]; then
+      ../../build/bin/l24 --run $file < $name.in > "$tmp_file"
+    else
+      ../../build/bin/l24 --run $file > "$tmp_file"
+    fi
+    echo $? >> "$tmp_file"
+
+    diff "$tmp_file" $name.out
+    if [ $(echo $?) != 0 ]; then
+      echo "result of ${file} is wrong"
+      rm "$tmp_file"
+      exit 1
+    else
+      echo "test ${file} success"
+    fi
+    rm "$tmp_file"
+  done
+done
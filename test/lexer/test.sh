@@ -0,0 +1,15 @@
+#!/bin/bash
+# the native lexer must produce the same tokens and lexical errors as the ANTLR lexer
+# on every test file
+
+for file in ../*/*.l24; do
+  antlr=$(../../build/bin/l24 $file --dump-tokens --lexer=antlr -emit-llvm -o /dev/null 2>&1)
+  native=$(../../build/bin/l24 $file --dump-tokens --lexer=native -emit-llvm -o /dev/null 2>&1)
+  if [ "$antlr" != "$native" ]; then
+    echo "tokens of ${file} differ"
+    diff <(echo "$antlr") <(echo "$native")
+    exit 1
+  else
+    echo "test ${file} success"
+  fi
+done
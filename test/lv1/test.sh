@@ -4,16 +4,13 @@ files=$(ls)
 for filename in $files
 do
   if [ "${filename##*.}" = "l24" ]; then
-    ../../build/bin/l24 ${filename} >> /dev/null
+    ../../build/bin/l24 ${filename} -o output >> /dev/null
     if [ $(echo $?) != 0 ]; then
       echo "runtime error"
-      rm output.S
-      rm output
+      rm -f output
       exit 1
     fi
 
-    gcc -L../../lib -lsysy "output.S" -o "output"
-
     tmp_file=$(mktemp /tmp/${filename%%.*}.output)
 
     if [ -e ${filename%%.*}.in ]; then
@@ -27,7 +24,6 @@ do
     diff "$tmp_file" ${filename%%.*}.out
     if [ $(echo $?) != 0 ]; then
       echo "result of ${filename} is wrong"
-      rm output.S
       rm output
       rm "$tmp_file"
       exit 1
@@ -37,5 +33,4 @@ do
     rm "$tmp_file"
   fi
 done
-rm output.S
 rm output
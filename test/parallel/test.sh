@@ -0,0 +1,53 @@
+#!/bin/bash
+# a large source parsed in chunks on several threads must give the same IR, or the same
+# syntax errors, as parsing it on one thread. the generated items put braces, ';' and
+# newlines into comments and string literals, where the source must not be split
+
+count=${1:-3000}
+out_dir=$(mktemp -d /tmp/l24_parallel.XXXXXX)
+src=$out_dir/big.l24
+
+for ((i = 0; i < count; i++)); do
+  cat >> "$src" <<EOT
+int g$i = $i, h$i[3] = {1, 2, $i};
+/* not the end of an item: } ;
+   int broken( { */
+int f$i(int a[], int n) { // } ;
+  char s[6] = "} ;
+{";
+  int i = 0;
+  while (i < n) { if (a[i] > g$i) then { a[i] = a[i] - h$i[2]; } end i = i + 1; }
+  return i + s[0];
+}
+
+EOT
+done
+echo "int main() { return 0; }" >> "$src"
+# a syntax error in the middle of the file
+sed "$((count / 2 * 11 + 9))s/return i/return i i/" "$src" > $out_dir/error.l24
+
+status=0
+for parser in antlr native; do
+  ../../build/bin/l24 $src --parser=$parser --parse-threads=1 -emit-llvm -o $out_dir/serial.ll
+  for threads in 2 4 0; do
+    ../../build/bin/l24 $src --parser=$parser --parse-threads=$threads -emit-llvm -o $out_dir/parallel.ll
+    if ! diff -q $out_dir/serial.ll $out_dir/parallel.ll > /dev/null; then
+      echo "IR of --parser=$parser --parse-threads=$threads differs"
+      status=1
+    fi
+  done
+
+  serial=$(../../build/bin/l24 $out_dir/error.l24 --parser=$parser --parse-threads=1 -emit-llvm -o /dev/null 2>&1)
+  parallel=$(../../build/bin/l24 $out_dir/error.l24 --parser=$parser --parse-threads=4 -emit-llvm -o /dev/null 2>&1)
+  if [ -z "$serial" ] || [ "$serial" != "$parallel" ]; then
+    echo "syntax errors of --parser=$parser differ"
+    diff <(echo "$serial") <(echo "$parallel")
+    status=1
+  fi
+  if [ $status == 0 ]; then
+    echo "test --parser=$parser success"
+  fi
+done
+
+rm -rf $out_dir
+exit $status
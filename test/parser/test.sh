@@ -0,0 +1,40 @@
+#!/bin/bash
+# the native parser must accept the same files as the ANTLR parser and build the same
+# AST, compared through the IR generated from it
+
+out_dir=$(mktemp -d /tmp/l24_parser.XXXXXX)
+for file in ../*/*.l24; do
+  ../../build/bin/l24 $file --parser=antlr -emit-llvm -o $out_dir/antlr.ll 2> /dev/null
+  antlr_status=$?
+  ../../build/bin/l24 $file --parser=native -emit-llvm -o $out_dir/native.ll 2> /dev/null
+  native_status=$?
+
+  if [ $antlr_status != $native_status ]; then
+    echo "${file} is accepted by only one parser"
+    rm -rf $out_dir
+    exit 1
+  fi
+  if [ $antlr_status == 0 ]; then
+    diff $out_dir/antlr.ll $out_dir/native.ll
+    if [ $(echo $?) != 0 ]; then
+      echo "IR of ${file} differs"
+      rm -rf $out_dir
+      exit 1
+    fi
+  fi
+  echo "test ${file} success"
+done
+
+# the files of this directory have at most one error, which both parsers report alike
+for file in *.l24; do
+  antlr=$(../../build/bin/l24 $file --parser=antlr -emit-llvm -o /dev/null 2>&1)
+  native=$(../../build/bin/l24 $file --parser=native -emit-llvm -o /dev/null 2>&1)
+  if [ "$antlr" != "$native" ]; then
+    echo "diagnostics of ${file} differ"
+    diff <(echo "$antlr") <(echo "$native")
+    rm -rf $out_dir
+    exit 1
+  fi
+  echo "test diagnostics of ${file} success"
+done
+rm -rf $out_dir
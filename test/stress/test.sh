@@ -0,0 +1,42 @@
+#!/bin/bash
+# a program of 100k top-level items (globals, functions and extern declarations) must
+# compile with every parser and run
+# usage: ./test.sh [number of items, default 100000]
+
+count=${1:-100000}
+out_dir=$(mktemp -d /tmp/l24_stress.XXXXXX)
+src=$out_dir/items.l24
+
+for ((i = 0; i < count / 4; i++)); do
+  cat >> "$src" <<EOT
+int g$i = $i;
+extern int e$i;
+const int c$i = $i % 7;
+int f$i(int n) { return n + g$i - c$i; }
+EOT
+done
+# the extern declarations are never used, so they need no definition
+last=$((count / 4 - 1))
+echo "int main() { return f$last(0) - g$last + 100; }" >> "$src"
+expected=$((100 - last % 7))
+
+status=0
+for options in "--parser=antlr" "--parser=native" "--parser=native --parse-threads=4"; do
+  ../../build/bin/l24 "$src" $options -o $out_dir/output > /dev/null
+  if [ $? != 0 ]; then
+    echo "${options}: compile error"
+    status=1
+    continue
+  fi
+  $out_dir/output
+  result=$?
+  if [ $result != $expected ]; then
+    echo "${options}: main returned ${result} instead of ${expected}"
+    status=1
+  else
+    echo "test ${options} success"
+  fi
+done
+
+rm -rf $out_dir
+exit $status